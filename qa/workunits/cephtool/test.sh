@@ -2451,6 +2451,18 @@ function test_mon_osd_tiered_pool_set()
   ceph osd pool get real-tier hit_set_type | grep "hit_set_type: explicit_object"
   ceph osd pool set real-tier hit_set_type bloom
   ceph osd pool get real-tier hit_set_type | grep "hit_set_type: bloom"
+  # blocked_bloom params are in the osdmap, so pre-squid clients must
+  # be locked out first
+  ceph osd get-require-min-compat-client | grep luminous
+  expect_false ceph osd pool set real-tier hit_set_type blocked_bloom
+  ceph osd pool get real-tier hit_set_type | grep "hit_set_type: bloom"
+  ceph osd set-require-min-compat-client squid
+  ceph osd pool set real-tier hit_set_type blocked_bloom
+  ceph osd pool get real-tier hit_set_type | grep "hit_set_type: blocked_bloom"
+  expect_false ceph osd set-require-min-compat-client luminous
+  ceph osd pool set real-tier hit_set_type bloom
+  ceph osd set-require-min-compat-client luminous
+  ceph osd get-require-min-compat-client | grep luminous
   expect_false ceph osd pool set real-tier hit_set_type i_dont_exist
   ceph osd pool set real-tier hit_set_period 123
   ceph osd pool get real-tier hit_set_period | grep "hit_set_period: 123"
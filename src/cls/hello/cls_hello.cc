@@ -30,6 +30,7 @@
  */
 
 #include <algorithm>
+#include <map>
 #include <string>
 #include <sstream>
 #include <cerrno>
@@ -274,6 +275,110 @@ static int bad_writer(cls_method_context_t hctx, bufferlist *in, bufferlist *out
   return cls_cxx_write_full(hctx, in);
 }
 
+/*
+ * the next two methods read the same omap keys and xattrs over and
+ * over; the OSD serves repeated reads within an op from a cache, and
+ * they return what each read saw so that the test can check that the
+ * cache gives the same answers as the object store would.
+ */
+static string describe(int r, const bufferlist& bl)
+{
+  if (r < 0)
+    return std::to_string(r);
+  return bl.to_str();
+}
+
+static string describe(int r, const std::map<string, bufferlist>& vals)
+{
+  if (r < 0)
+    return std::to_string(r);
+  string s;
+  for (const auto& [key, val] : vals) {
+    s += key + "=" + val.to_str() + ";";
+  }
+  return s;
+}
+
+/**
+ * reread - a "read" method that looks up the same keys more than once
+ */
+static int reread(cls_method_context_t hctx, bufferlist *in, bufferlist *out)
+{
+  std::map<string, string> seen;
+  bufferlist bl;
+  std::map<string, bufferlist> vals;
+
+  // negative lookups are remembered as well
+  int r = cls_cxx_map_get_val(hctx, "missing", &bl);
+  seen["missing"] = describe(r, bl);
+  r = cls_cxx_map_get_val(hctx, "missing", &bl);
+  seen["missing_again"] = describe(r, bl);
+  r = cls_cxx_getxattr(hctx, "missing", &bl);
+  seen["xattr_missing"] = describe(r, bl);
+  r = cls_cxx_getxattr(hctx, "missing", &bl);
+  seen["xattr_missing_again"] = describe(r, bl);
+  r = cls_cxx_getxattr(hctx, "x", &bl);
+  seen["xattr"] = describe(r, bl);
+  r = cls_cxx_getxattr(hctx, "x", &bl);
+  seen["xattr_again"] = describe(r, bl);
+
+  // a is cached, b is not, missing is cached as absent
+  r = cls_cxx_map_get_val(hctx, "a", &bl);
+  seen["a"] = describe(r, bl);
+  r = cls_cxx_map_get_vals_by_keys(hctx, {"a", "b", "missing"}, &vals);
+  seen["by_keys"] = describe(r, vals);
+  r = cls_cxx_map_get_val(hctx, "b", &bl);
+  seen["b"] = describe(r, bl);
+
+  encode(seen, *out);
+  return 0;
+}
+
+/**
+ * reread_after_write - a "read/write" method that reads keys again
+ * after updating them
+ *
+ * Reads see the object as it was before the op, except that an omap
+ * clear (or a delete) makes later omap reads come back empty.
+ */
+static int reread_after_write(cls_method_context_t hctx, bufferlist *in,
+			      bufferlist *out)
+{
+  std::map<string, string> seen;
+  bufferlist bl;
+  std::map<string, bufferlist> vals;
+
+  int r = cls_cxx_map_get_val(hctx, "a", &bl);
+  seen["a"] = describe(r, bl);
+  r = cls_cxx_map_get_vals_by_keys(hctx, {"a", "b"}, &vals);
+  seen["by_keys"] = describe(r, vals);
+
+  bufferlist val;
+  val.append("3");
+  r = cls_cxx_map_set_val(hctx, "a", &val);
+  if (r < 0)
+    return r;
+  r = cls_cxx_map_get_val(hctx, "a", &bl);
+  seen["a_after_set"] = describe(r, bl);
+
+  r = cls_cxx_map_remove_key(hctx, "b");
+  if (r < 0)
+    return r;
+  r = cls_cxx_map_get_vals_by_keys(hctx, {"a", "b"}, &vals);
+  seen["by_keys_after_remove"] = describe(r, vals);
+
+  r = cls_cxx_map_clear(hctx);
+  if (r < 0)
+    return r;
+  r = cls_cxx_map_get_val(hctx, "a", &bl);
+  seen["a_after_clear"] = describe(r, bl);
+  r = cls_cxx_map_get_vals_by_keys(hctx, {"a", "b"}, &vals);
+  seen["by_keys_after_clear"] = describe(r, vals);
+
+  encode(seen, *out);
+  return 0;
+}
+
 
 class PGLSHelloFilter : public PGLSFilter {
   string val;
@@ -325,6 +430,8 @@ CLS_INIT(hello)
   cls_method_handle_t h_turn_it_to_11;
   cls_method_handle_t h_bad_reader;
   cls_method_handle_t h_bad_writer;
+  cls_method_handle_t h_reread;
+  cls_method_handle_t h_reread_after_write;
 
   cls_register("hello", &h_class);
 
@@ -368,6 +475,13 @@ CLS_INIT(hello)
   cls_register_cxx_method(h_class, "bad_writer", CLS_METHOD_RD,
 			  bad_writer, &h_bad_writer);
 
+  // repeated reads within an op
+  cls_register_cxx_method(h_class, "reread", CLS_METHOD_RD,
+			  reread, &h_reread);
+  cls_register_cxx_method(h_class, "reread_after_write",
+			  CLS_METHOD_RD | CLS_METHOD_WR,
+			  reread_after_write, &h_reread_after_write);
+
   // A PGLS filter
   cls_register_cxx_filter(h_class, "hello", hello_filter);
 }
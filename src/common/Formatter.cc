@@ -101,9 +101,9 @@ Formatter *Formatter::create(std::string_view type,
   }
 
   if (mytype == "json")
-    return new JSONFormatter(false);
+    return new JSONFormatterStream(false);
   else if (mytype == "json-pretty")
-    return new JSONFormatter(true);
+    return new JSONFormatterStream(true);
   else if (mytype == "xml")
     return new XMLFormatter(false);
   else if (mytype == "xml-pretty")
@@ -167,6 +167,16 @@ void JSONFormatter::flush(std::ostream& os)
   m_ss.str("");
 }
 
+void JSONFormatter::flush(bufferlist& bl)
+{
+  finish_pending_string();
+  bl.append(m_ss.view());
+  if (m_line_break_enabled)
+    bl.append('\n');
+  m_ss.clear();
+  m_ss.str("");
+}
+
 void JSONFormatter::reset()
 {
   m_stack.clear();
@@ -299,10 +309,15 @@ void JSONFormatter::finish_pending_string()
 template <class T>
 void JSONFormatter::add_value(std::string_view name, T val)
 {
-  CachedStackStringStream css;
-  css->precision(std::numeric_limits<T>::max_digits10);
-  *css << val;
-  add_value(name, css->strv(), false);
+  if constexpr (std::is_integral_v<T>) {
+    fmt::format_int i(val);
+    add_value(name, std::string_view(i.data(), i.size()), false);
+  } else {
+    CachedStackStringStream css;
+    css->precision(std::numeric_limits<T>::max_digits10);
+    *css << val;
+    add_value(name, css->strv(), false);
+  }
 }
 
 void JSONFormatter::add_value(std::string_view name, std::string_view val, bool quoted)
@@ -370,6 +385,113 @@ void JSONFormatter::write_raw_data(const char *data)
   get_ss() << data;
 }
 
+// -----------------------
+
+class JSONFormatterStream::chunk_streambuf : public std::streambuf {
+  // start small for the many short outputs, and grow for large dumps
+  static constexpr size_t MIN_CHUNK = 4096;
+  static constexpr size_t MAX_CHUNK = 64 * 1024;
+
+  sink_t sink;
+  bufferlist bl;     // output committed so far
+  bufferptr chunk;   // current chunk; [pbase(), pptr()) not yet in bl
+  size_t next_chunk_size = MIN_CHUNK;
+
+  void next_chunk() {
+    commit();
+    if (sink && bl.length()) {
+      sink(std::move(bl));
+      bl.clear();
+    }
+    chunk = buffer::create(next_chunk_size);
+    next_chunk_size = std::min(next_chunk_size * 2, MAX_CHUNK);
+    setp(chunk.c_str(), chunk.c_str() + chunk.length());
+  }
+
+protected:
+  int_type overflow(int_type c) override {
+    next_chunk();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    for (auto left = n; left > 0; ) {
+      if (pptr() == epptr()) {
+	next_chunk();
+      }
+      auto len = std::min<std::streamsize>(left, epptr() - pptr());
+      memcpy(pptr(), s, len);
+      pbump(len);
+      s += len;
+      left -= len;
+    }
+    return n;
+  }
+
+public:
+  explicit chunk_streambuf(sink_t sink) : sink(std::move(sink)) {}
+
+  /// move what was written into the current chunk to bl; this shares the
+  /// chunk and merges with the previous commit, so it copies nothing
+  void commit() {
+    if (pptr() != pbase()) {
+      bl.append(chunk, pbase() - chunk.c_str(), pptr() - pbase());
+      setp(pptr(), epptr());
+    }
+  }
+  void claim(bufferlist& out) {
+    commit();
+    out.claim_append(bl);
+  }
+  void clear() {
+    bl.clear();
+    setp(pptr(), epptr());
+  }
+  size_t length() const {
+    return bl.length() + (pptr() - pbase());
+  }
+};
+
+JSONFormatterStream::JSONFormatterStream(bool pretty, sink_t sink)
+  : JSONFormatter(pretty),
+    m_buf(std::make_unique<chunk_streambuf>(std::move(sink))),
+    m_out(m_buf.get())
+{
+}
+
+JSONFormatterStream::~JSONFormatterStream() = default;
+
+void JSONFormatterStream::flush(std::ostream& os)
+{
+  bufferlist bl;
+  flush(bl);
+  bl.write_stream(os);
+}
+
+void JSONFormatterStream::flush(bufferlist& bl)
+{
+  finish_pending_string();
+  m_buf->claim(bl);
+  if (line_break_enabled())
+    bl.append('\n');
+}
+
+void JSONFormatterStream::reset()
+{
+  JSONFormatter::reset();
+  m_buf->clear();
+  m_out.clear();
+}
+
+int JSONFormatterStream::get_len() const
+{
+  return m_buf->length();
+}
+
 const char *XMLFormatter::XML_1_DTD =
   "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
 
@@ -8,6 +8,7 @@
 
 #include <deque>
 #include <fstream>
+#include <functional>
 #include <list>
 #include <memory>
 #include <vector>
@@ -77,7 +78,7 @@ namespace ceph {
 
     virtual void enable_line_break() = 0;
     virtual void flush(std::ostream& os) = 0;
-    void flush(bufferlist &bl);
+    virtual void flush(bufferlist &bl);
     virtual void reset() = 0;
 
     virtual void set_status(int status, const char* status_name) = 0;
@@ -183,7 +184,7 @@ namespace ceph {
     void output_footer() override {};
     void enable_line_break() override { m_line_break_enabled = true; }
     void flush(std::ostream& os) override;
-    using Formatter::flush; // don't hide Formatter::flush(bufferlist &bl)
+    void flush(bufferlist& bl) override;
     void reset() override;
     void open_array_section(std::string_view name) override;
     void open_array_section_in_ns(std::string_view name, const char *ns) override;
@@ -221,6 +222,10 @@ protected:
 
     void finish_pending_string();
 
+    bool line_break_enabled() const {
+      return m_line_break_enabled;
+    }
+
 private:
     struct json_formatter_stack_entry_d {
       int size = 0;
@@ -260,6 +265,9 @@ public:
     void flush(std::ostream& os) override {
       flush();
     }
+    void flush(bufferlist& bl) override {
+      flush();
+    }
     void flush() {
       JSONFormatter::finish_pending_string();
       file.flush();
@@ -286,6 +294,41 @@ private:
     mutable std::ofstream file; // mutable for get_len
   };
 
+  /**
+   * JSONFormatter that builds its output in a bufferlist, one chunk at a
+   * time, instead of a stringstream that is reallocated as it grows and
+   * copied again on flush.  flush(bufferlist&) hands over the chunks
+   * without copying them.
+   *
+   * If a sink is given, each chunk is passed to it as soon as it fills
+   * up, so a large dump can be written out while it is being built; flush()
+   * then only returns what is left.
+   */
+  class JSONFormatterStream : public JSONFormatter {
+  public:
+    using sink_t = std::function<void(bufferlist&&)>;
+
+    explicit JSONFormatterStream(bool pretty = false, sink_t sink = {});
+    ~JSONFormatterStream() override;
+    JSONFormatterStream(const JSONFormatterStream&) = delete;
+    JSONFormatterStream& operator=(const JSONFormatterStream&) = delete;
+
+    void flush(std::ostream& os) override;
+    void flush(bufferlist& bl) override;
+    void reset() override;
+    int get_len() const override;
+
+  protected:
+    std::ostream& get_ss() override {
+      return m_out;
+    }
+
+  private:
+    class chunk_streambuf;
+    std::unique_ptr<chunk_streambuf> m_buf;
+    std::ostream m_out;
+  };
+
   template <class T>
   void add_value(std::string_view name, T val);
 
@@ -10,7 +10,10 @@
  * Copyright 2013 Inktank
  */
 
+#include <algorithm>
+
 #include "TrackedOp.h"
+#include "common/perf_counters_shard.h"
 
 #define dout_context cct
 #define dout_subsys ceph_subsys_optracker
@@ -32,6 +35,53 @@ static ostream& _prefix(std::ostream* _dout)
   return *_dout << "-- op tracker -- ";
 }
 
+static const struct {
+  const char *name;
+  const char *counter;
+  const char *desc;
+} op_stages[NUM_OP_STAGES] = {
+  {"initiated", "stage_initiated_lat",
+   "Latency of ops reaching initiated"},
+  {"header_read", "stage_header_read_lat",
+   "Latency from initiated to header read"},
+  {"throttled", "stage_throttled_lat",
+   "Latency waiting on the message throttle"},
+  {"all_read", "stage_all_read_lat",
+   "Latency reading the rest of the message"},
+  {"dispatched", "stage_dispatched_lat",
+   "Latency from read to dispatch"},
+  {"queued_for_pg", "stage_queued_for_pg_lat",
+   "Latency from dispatch to the op queue"},
+  {"reached_pg", "stage_reached_pg_lat",
+   "Latency in the op queue"},
+  {"started", "stage_started_lat",
+   "Latency from reaching the PG to starting"},
+  {"op_commit", "stage_op_commit_lat",
+   "Latency to the local commit"},
+  {"sub_op_commit_rec", "stage_sub_op_commit_rec_lat",
+   "Latency to the last replica commit received"},
+  {"commit_sent", "stage_commit_sent_lat",
+   "Latency to the reply being sent"},
+  {"done", "stage_done_lat",
+   "Latency from the last stage to completion"},
+};
+
+const char *op_stage_name(op_stage_t stage)
+{
+  ceph_assert(stage < op_stage_t::num_stages);
+  return op_stages[static_cast<unsigned>(stage)].name;
+}
+
+void OpHistory::add_stage_counters(PerfCountersBuilder& b)
+{
+  for (unsigned i = 0; i < NUM_OP_STAGES; ++i) {
+    b.add_time_avg(l_osd_op_stage_lat + i, op_stages[i].counter,
+		   op_stages[i].desc);
+    // bumped by every completing op
+    b.set_sharded(l_osd_op_stage_lat + i);
+  }
+}
+
 void OpHistoryServiceThread::break_thread() {
   queue_spinlock.lock();
   _external_queue.clear();
@@ -152,6 +202,7 @@ void OpHistory::dump_ops(utime_t now, Formatter *f, set<string> filters, bool by
 struct ShardedTrackingData {
   ceph::mutex ops_in_flight_lock_sharded;
   TrackedOp::tracked_op_list_t ops_in_flight_sharded;
+  OpStageHistogram stage_hist;
   explicit ShardedTrackingData(string lock_name)
     : ops_in_flight_lock_sharded(ceph::make_mutex(lock_name)) {}
 };
@@ -311,6 +362,62 @@ void OpTracker::unregister_inflight_op(TrackedOp* const i)
   }
 }
 
+void OpTracker::record_stage_latencies(const TrackedOp& op)
+{
+  // charge every well known event the op reached with the time since
+  // the one reached before it.  A stage may be reached more than once
+  // (e.g. a requeued op, or a commit from each replica), and each time
+  // counts.
+  TrackedOp::stage_marks_t reached;
+  op.get_stages(reached);
+  // marks may be made with stamps taken earlier (e.g. the message's)
+  std::stable_sort(reached.begin(), reached.end(),
+		   [](const auto& a, const auto& b) {
+		     return a.first < b.first;
+		   });
+  // not op.seq: untracked ops all have seq 0
+  auto& hist = sharded_in_flight_list[
+    ceph::perf_counters::pick_shard() % num_optracker_shards]->stage_hist;
+  for (unsigned i = 1; i < reached.size(); ++i) {
+    utime_t lat = reached[i].first - reached[i - 1].first;
+    hist.add(reached[i].second, lat.to_nsec() / 1000);
+    history.log_stage_latency(reached[i].second, lat);
+  }
+}
+
+void OpTracker::dump_stage_histograms(Formatter *f)
+{
+  f->open_array_section("op_stages");
+  for (unsigned i = 0; i < NUM_OP_STAGES; ++i) {
+    auto stage = static_cast<op_stage_t>(i);
+    uint64_t count = 0, sum_usec = 0;
+    std::array<uint64_t, OpStageHistogram::NUM_BUCKETS> buckets = {};
+    for (auto sdata : sharded_in_flight_list) {
+      count += sdata->stage_hist.get_count(stage);
+      sum_usec += sdata->stage_hist.get_sum_usec(stage);
+      for (unsigned b = 0; b < buckets.size(); ++b) {
+	buckets[b] += sdata->stage_hist.get_bucket(stage, b);
+      }
+    }
+    f->open_object_section("stage");
+    f->dump_string("stage", op_stage_name(stage));
+    f->dump_unsigned("count", count);
+    f->dump_unsigned("avg_usec", count ? sum_usec / count : 0);
+    // bucket b holds [2^(b-1), 2^b) usec
+    f->open_array_section("histogram_usec");
+    unsigned last = buckets.size();
+    while (last > 0 && buckets[last - 1] == 0) {
+      --last;
+    }
+    for (unsigned b = 0; b < last; ++b) {
+      f->dump_unsigned("count", buckets[b]);
+    }
+    f->close_section();
+    f->close_section();
+  }
+  f->close_section();
+}
+
 void OpTracker::record_history_op(TrackedOpRef&& i)
 {
   std::shared_lock l{lock};
@@ -499,6 +606,49 @@ void TrackedOp::mark_event(std::string_view event, utime_t stamp)
   _event_marked();
 }
 
+void TrackedOp::mark_event(op_stage_t stage, utime_t stamp)
+{
+  if (!state) {
+    // stage latencies are recorded whether the op is tracked or not,
+    // so remember the stage without the lock or the events vector
+    unsigned i = num_untracked_stages.fetch_add(1, std::memory_order_relaxed);
+    if (i < MAX_UNTRACKED_STAGES) {
+      untracked_stamps[i] = stamp;
+      untracked_stages[i] = stage;
+    }
+    return;
+  }
+
+  {
+    std::lock_guard l(lock);
+    events.emplace_back(stamp, stage);
+  }
+  dout(6) << " seq: " << seq
+	  << ", time: " << stamp
+	  << ", event: " << op_stage_name(stage)
+	  << ", op: " << get_desc()
+	  << dendl;
+  _event_marked();
+}
+
+void TrackedOp::get_stages(stage_marks_t& stages) const
+{
+  if (state) {
+    std::lock_guard l(lock);
+    for (const auto& e : events) {
+      if (e.stage != op_stage_t::num_stages) {
+	stages.emplace_back(e.stamp, e.stage);
+      }
+    }
+  } else {
+    unsigned n = std::min(num_untracked_stages.load(std::memory_order_relaxed),
+			  MAX_UNTRACKED_STAGES);
+    for (unsigned i = 0; i < n; ++i) {
+      stages.emplace_back(untracked_stamps[i], untracked_stages[i]);
+    }
+  }
+}
+
 void TrackedOp::dump(utime_t now, Formatter *f, OpTracker::dumper lambda) const
 {
   // Ignore if still in the constructor
@@ -14,12 +14,15 @@
 #ifndef TRACKEDREQUEST_H_
 #define TRACKEDREQUEST_H_
 
+#include <array>
 #include <atomic>
+#include <boost/container/small_vector.hpp>
 #include "common/StackStringStream.h"
 #include "common/ceph_mutex.h"
 #include "common/histogram.h"
 #include "common/Thread.h"
 #include "common/Clock.h"
+#include "include/intarith.h"
 #include "include/spinlock.h"
 #include "msg/Message.h"
 
@@ -30,6 +33,69 @@ class OpHistory;
 
 typedef boost::intrusive_ptr<TrackedOp> TrackedOpRef;
 
+/**
+ * well known op events
+ *
+ * Marking one of these stores no string.  When the op completes, the
+ * time since the previous well known event it reached is added to the
+ * OpTracker's latency histogram for the stage ending with this event.
+ */
+enum class op_stage_t : uint8_t {
+  initiated,
+  header_read,
+  throttled,
+  all_read,
+  dispatched,
+  queued_for_pg,
+  reached_pg,
+  started,
+  op_commit,
+  sub_op_commit_rec,
+  commit_sent,
+  done,
+  num_stages
+};
+static constexpr unsigned NUM_OP_STAGES =
+  static_cast<unsigned>(op_stage_t::num_stages);
+
+/// the event name, as it would have been marked by string
+const char *op_stage_name(op_stage_t stage);
+
+/// per stage latency histograms, updated without locks
+class OpStageHistogram {
+public:
+  /// bucket b counts latencies in [2^(b-1), 2^b) usec; the last is open
+  static constexpr unsigned NUM_BUCKETS = 32;
+
+  void add(op_stage_t stage, uint64_t usec) {
+    auto& s = stages[static_cast<unsigned>(stage)];
+    unsigned b = std::min(cbits(usec), NUM_BUCKETS - 1);
+    s.buckets[b].fetch_add(1, std::memory_order_relaxed);
+    s.count.fetch_add(1, std::memory_order_relaxed);
+    s.sum_usec.fetch_add(usec, std::memory_order_relaxed);
+  }
+  uint64_t get_count(op_stage_t stage) const {
+    return stages[static_cast<unsigned>(stage)].count.load(
+      std::memory_order_relaxed);
+  }
+  uint64_t get_sum_usec(op_stage_t stage) const {
+    return stages[static_cast<unsigned>(stage)].sum_usec.load(
+      std::memory_order_relaxed);
+  }
+  uint64_t get_bucket(op_stage_t stage, unsigned b) const {
+    return stages[static_cast<unsigned>(stage)].buckets[b].load(
+      std::memory_order_relaxed);
+  }
+
+private:
+  struct stage_hist_t {
+    std::atomic<uint64_t> count = {0};
+    std::atomic<uint64_t> sum_usec = {0};
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> buckets = {};
+  };
+  std::array<stage_hist_t, NUM_OP_STAGES> stages;
+};
+
 class OpHistoryServiceThread : public Thread
 {
 private:
@@ -55,7 +121,8 @@ public:
 enum {
   l_osd_slow_op_first = 1000,
   l_osd_slow_op_count,
-  l_osd_slow_op_last,
+  l_osd_op_stage_lat,
+  l_osd_slow_op_last = l_osd_op_stage_lat + NUM_OP_STAGES,
 };
 
 class OpHistory {
@@ -80,6 +147,7 @@ public:
                          l_osd_slow_op_first, l_osd_slow_op_last);
     b.add_u64_counter(l_osd_slow_op_count, "slow_ops_count",
                       "Number of operations taking over ten second");
+    add_stage_counters(b);
 
     logger.reset(b.create_perf_counters());
     cct->get_perfcounters_collection()->add(logger.get());
@@ -103,6 +171,11 @@ public:
     opsvc.insert_op(now, op);
   }
 
+  void log_stage_latency(op_stage_t stage, utime_t lat) {
+    logger->tinc(l_osd_op_stage_lat + static_cast<unsigned>(stage), lat);
+  }
+
+  static void add_stage_counters(PerfCountersBuilder& b);
   void _insert_delayed(const utime_t& now, TrackedOpRef op);
   void dump_ops(utime_t now, ceph::Formatter *f, std::set<std::string> filters = {""}, bool by_duration=false);
   void dump_slow_ops(utime_t now, ceph::Formatter *f, std::set<std::string> filters = {""});
@@ -155,8 +228,10 @@ public:
   bool dump_ops_in_flight(ceph::Formatter *f, bool print_only_blocked = false, std::set<std::string> filters = {""}, bool count_only = false, dumper lambda = default_dumper);
   bool dump_historic_ops(ceph::Formatter *f, bool by_duration = false, std::set<std::string> filters = {""});
   bool dump_historic_slow_ops(ceph::Formatter *f, std::set<std::string> filters = {""});
+  void dump_stage_histograms(ceph::Formatter *f);
   bool register_inflight_op(TrackedOp *i);
   void unregister_inflight_op(TrackedOp *i);
+  void record_stage_latencies(const TrackedOp& op);
   void record_history_op(TrackedOpRef&& i);
 
   void get_age_ms_histogram(pow2_hist_t *h);
@@ -214,12 +289,12 @@ public:
     };
     typename R::Ref retval(new R(params, this));
     retval->tracking_start();
-    if (is_tracking()) {
-      retval->mark_event("header_read", params->get_recv_stamp());
-      retval->mark_event("throttled", params->get_throttle_stamp());
-      retval->mark_event("all_read", params->get_recv_complete_stamp());
-      retval->mark_event("dispatched", params->get_dispatch_stamp());
-    }
+    retval->mark_event(op_stage_t::header_read, params->get_recv_stamp());
+    retval->mark_event(op_stage_t::throttled, params->get_throttle_stamp());
+    retval->mark_event(op_stage_t::all_read,
+		       params->get_recv_complete_stamp());
+    retval->mark_event(op_stage_t::dispatched,
+		       params->get_dispatch_stamp());
     if constexpr (enable_mark_continuous) {
       if (params->is_continuous()) {
         retval->mark_continuous();
@@ -263,26 +338,35 @@ protected:
 
   struct Event {
     utime_t stamp;
+    op_stage_t stage;  ///< num_stages if the event is named by str
     std::string str;
 
-    Event(utime_t t, std::string_view s) : stamp(t), str(s) {}
+    Event(utime_t t, std::string_view s)
+      : stamp(t), stage(op_stage_t::num_stages), str(s) {}
+    Event(utime_t t, op_stage_t s) : stamp(t), stage(s) {}
 
-    int compare(const char *s) const {
-      return str.compare(s);
-    }
-
-    const char *c_str() const {
-      return str.c_str();
+    std::string_view name() const {
+      if (stage == op_stage_t::num_stages) {
+	return str;
+      }
+      return op_stage_name(stage);
     }
 
     void dump(ceph::Formatter *f) const {
       f->dump_stream("time") << stamp;
-      f->dump_string("event", str);
+      f->dump_string("event", name());
     }
   };
 
   std::vector<Event> events;    ///< std::list of events and their times
   mutable ceph::mutex lock = ceph::make_mutex("TrackedOp::lock"); ///< to protect the events list
+
+  /// stages marked while the op is not tracked, in the order marked;
+  /// filled without the lock, read once the last reference is gone
+  static constexpr unsigned MAX_UNTRACKED_STAGES = 24;
+  std::atomic<unsigned> num_untracked_stages = {0};
+  std::array<utime_t, MAX_UNTRACKED_STAGES> untracked_stamps;
+  std::array<op_stage_t, MAX_UNTRACKED_STAGES> untracked_stages;
   uint64_t seq = 0;        ///< a unique value std::set by the OpTracker
 
   uint32_t warn_interval_multiplier = 1; //< limits output of a given op warning
@@ -337,12 +421,15 @@ public:
     if (nref_snap == 1) {
       switch (state.load()) {
       case STATE_UNTRACKED:
+	mark_event(op_stage_t::done);
+	tracker->record_stage_latencies(*this);
 	_unregistered();
 	delete this;
 	break;
 
       case STATE_LIVE:
-	mark_event("done");
+	mark_event(op_stage_t::done);
+	tracker->record_stage_latencies(*this);
 	tracker->unregister_inflight_op(this);
 	_unregistered();
 	if (!tracker->is_tracking()) {
@@ -407,13 +494,19 @@ public:
 
   double get_duration() const {
     std::lock_guard l(lock);
-    if (!events.empty() && events.rbegin()->compare("done") == 0)
+    if (!events.empty() && events.rbegin()->stage == op_stage_t::done)
       return events.rbegin()->stamp - get_initiated();
     else
       return ceph_clock_now() - get_initiated();
   }
 
+  using stage_marks_t = boost::container::small_vector<
+    std::pair<utime_t, op_stage_t>, MAX_UNTRACKED_STAGES>;
+  /// every stage the op reached, in the order marked
+  void get_stages(stage_marks_t& stages) const;
+
   void mark_event(std::string_view event, utime_t stamp=ceph_clock_now());
+  void mark_event(op_stage_t stage, utime_t stamp=ceph_clock_now());
 
   void mark_nowarn() {
     warn_interval_multiplier = 0;
@@ -428,9 +521,9 @@ public:
 
   void tracking_start() {
     if (tracker->register_inflight_op(this)) {
-      events.emplace_back(initiated_at, "initiated");
       state = STATE_LIVE;
     }
+    mark_event(op_stage_t::initiated, initiated_at);
   }
 
   // ref counting via intrusive_ptr, with special behavior on final
@@ -444,7 +537,8 @@ public:
 
 protected:
   virtual std::string _get_state_string() const {
-    return events.empty() ? std::string() : std::string(events.rbegin()->str);
+    return events.empty() ? std::string() :
+      std::string(events.rbegin()->name());
   }
 };
 
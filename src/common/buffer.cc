@@ -81,15 +81,216 @@ static ceph::spinlock debug_lock;
     return buffer_missed_crc;
   }
 
+namespace {
+  /*
+   * Per thread cache of the small allocations backing raw_combined.
+   *
+   * Encoding churns through raw_combined buffers of a few hundred bytes
+   * up to a few pages, each a malloc and a free.  Keep the freed blocks
+   * in power of two size classes per thread instead, and hand them out
+   * again on the next create().  A block freed by another thread goes
+   * back to the cache it came from via a lock-free list, which the
+   * owner drains when its own list of that class runs dry.  Both the
+   * local and the remote lists of a thread hold at most MAX_CACHED_BYTES
+   * across all classes; anything beyond that goes back to the heap right
+   * away.  Cached blocks are accounted in the buffer_cache mempool.
+   *
+   * Caches are never freed: when a thread exits its cache is orphaned,
+   * blocks freed to it from then on go straight back to the heap, and
+   * the next new thread adopts it along with whatever was freed to it
+   * in the meantime.  Set CEPH_BUFFER_NO_POOL to bypass the caches,
+   * e.g. when looking for use-after-free bugs.
+   */
+  class raw_pool {
+  public:
+    static constexpr unsigned MIN_ORDER = 8;   // 256 bytes
+    static constexpr unsigned NUM_CLASSES = 6; // ... 8K
+    static constexpr size_t BLOCK_ALIGN = alignof(std::max_align_t);
+    static constexpr size_t MAX_CACHED_BYTES = 65536; // local, and remote
+
+    static constexpr size_t class_size(unsigned cls) {
+      return size_t(1) << (MIN_ORDER + cls);
+    }
+    /// size class for an allocation of size bytes, NUM_CLASSES if too big
+    static unsigned class_of(size_t size) {
+      if (size > class_size(NUM_CLASSES - 1)) {
+	return NUM_CLASSES;
+      }
+      unsigned order = cbits(size - 1);
+      return order > MIN_ORDER ? order - MIN_ORDER : 0;
+    }
+
+    /// the calling thread's cache, or nullptr if pooling is disabled
+    static raw_pool *get();
+    /// the calling thread's cache if it has one, without creating it
+    static raw_pool *current() {
+      return tls.pool;
+    }
+
+    char *alloc(unsigned cls) {
+      if (!local[cls] && remote.load(std::memory_order_relaxed)) {
+	drain_remote();
+      }
+      if (free_block *b = local[cls]) {
+	local[cls] = b->next;
+	local_bytes -= class_size(cls);
+	account(-1, -(ssize_t)class_size(cls));
+	return reinterpret_cast<char *>(b);
+      }
+      char *ptr = nullptr;
+      if (::posix_memalign((void**)(void*)&ptr, BLOCK_ALIGN, class_size(cls))) {
+	throw buffer::bad_alloc();
+      }
+      return ptr;
+    }
+
+    void free(char *ptr, unsigned cls) {
+      auto b = reinterpret_cast<free_block *>(ptr);
+      if (this == current()) {
+	put_local(b, cls);
+      } else if (orphaned.load(std::memory_order_acquire)) {
+	aligned_free(ptr);
+      } else if (remote_bytes.fetch_add(class_size(cls),
+					std::memory_order_relaxed) +
+		 class_size(cls) > MAX_CACHED_BYTES) {
+	// the owner is not keeping up; don't let its remote list grow
+	remote_bytes.fetch_sub(class_size(cls), std::memory_order_relaxed);
+	aligned_free(ptr);
+      } else {
+	account(1, class_size(cls));
+	b->cls = cls;
+	auto head = remote.load(std::memory_order_relaxed);
+	do {
+	  b->next = head;
+	} while (!remote.compare_exchange_weak(head, b,
+					       std::memory_order_release,
+					       std::memory_order_relaxed));
+      }
+    }
+
+  private:
+    struct free_block {
+      free_block *next;
+      unsigned cls;
+    };
+
+    free_block *local[NUM_CLASSES] = {};
+    size_t local_bytes = 0;
+    std::atomic<free_block *> remote = nullptr;
+    std::atomic<size_t> remote_bytes = 0;
+    std::atomic<bool> orphaned = false;
+    raw_pool *next_orphan = nullptr;
+
+    struct holder {
+      raw_pool *pool = nullptr;
+      bool destructed = false;
+      ~holder();
+    };
+    static thread_local holder tls;
+    static ceph::spinlock orphans_lock;
+    static raw_pool *orphans;
+
+    static void account(ssize_t items, ssize_t bytes) {
+      mempool::get_pool(mempool::mempool_buffer_cache).adjust_count(
+	items, bytes);
+    }
+    void put_local(free_block *b, unsigned cls) {
+      if (local_bytes + class_size(cls) > MAX_CACHED_BYTES) {
+	aligned_free(b);
+	return;
+      }
+      b->next = local[cls];
+      local[cls] = b;
+      local_bytes += class_size(cls);
+      account(1, class_size(cls));
+    }
+    void drain_remote() {
+      free_block *b = remote.exchange(nullptr, std::memory_order_acquire);
+      int items = 0;
+      size_t bytes = 0;
+      while (b) {
+	free_block *next = b->next;
+	++items;
+	bytes += class_size(b->cls);
+	put_local(b, b->cls);
+	b = next;
+      }
+      if (items) {
+	remote_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+	account(-items, -(ssize_t)bytes);
+      }
+    }
+    void release_all() {
+      int items = 0;
+      for (unsigned cls = 0; cls < NUM_CLASSES; ++cls) {
+	while (free_block *b = local[cls]) {
+	  local[cls] = b->next;
+	  aligned_free(b);
+	  ++items;
+	}
+      }
+      if (items) {
+	account(-items, -(ssize_t)local_bytes);
+      }
+      local_bytes = 0;
+    }
+  };
+
+  thread_local raw_pool::holder raw_pool::tls;
+  ceph::spinlock raw_pool::orphans_lock;
+  raw_pool *raw_pool::orphans = nullptr;
+  static const bool buffer_no_pool = get_env_bool("CEPH_BUFFER_NO_POOL");
+
+  raw_pool *raw_pool::get() {
+    auto& h = tls;
+    if (likely(h.pool != nullptr)) {
+      return h.pool;
+    }
+    if (buffer_no_pool || h.destructed) {
+      return nullptr;
+    }
+    {
+      std::lock_guard l(orphans_lock);
+      if (orphans) {
+	h.pool = orphans;
+	orphans = h.pool->next_orphan;
+      }
+    }
+    if (h.pool) {
+      h.pool->orphaned.store(false, std::memory_order_release);
+    } else {
+      h.pool = new raw_pool;
+    }
+    return h.pool;
+  }
+
+  raw_pool::holder::~holder() {
+    destructed = true;
+    if (!pool) {
+      return;
+    }
+    pool->orphaned.store(true, std::memory_order_release);
+    pool->drain_remote();
+    pool->release_all();
+    std::lock_guard l(orphans_lock);
+    pool->next_orphan = orphans;
+    orphans = pool;
+    pool = nullptr;
+  }
+} // anonymous namespace
+
   /*
    * raw_combined is always placed within a single allocation along
    * with the data buffer.  the data goes at the beginning, and
    * raw_combined at the end.
    */
   class buffer::raw_combined : public buffer::raw {
+    raw_pool *pool;
+    unsigned pool_class;
   public:
-    raw_combined(char *dataptr, unsigned l, int mempool)
-      : raw(dataptr, l, mempool) {
+    raw_combined(char *dataptr, unsigned l, int mempool,
+		 raw_pool *pool = nullptr, unsigned pool_class = 0)
+      : raw(dataptr, l, mempool), pool(pool), pool_class(pool_class) {
     }
 
     static ceph::unique_leakable_ptr<buffer::raw>
@@ -103,6 +304,16 @@ static ceph::spinlock debug_lock;
 				  alignof(buffer::raw_combined));
       size_t datalen = round_up_to(len, alignof(buffer::raw_combined));
 
+      if (align <= raw_pool::BLOCK_ALIGN) {
+	unsigned cls = raw_pool::class_of(rawlen + datalen);
+	raw_pool *pool;
+	if (cls < raw_pool::NUM_CLASSES && (pool = raw_pool::get())) {
+	  char *ptr = pool->alloc(cls);
+	  return ceph::unique_leakable_ptr<buffer::raw>(
+	    new (ptr + datalen) raw_combined(ptr, len, mempool, pool, cls));
+	}
+      }
+
 #ifdef DARWIN
       char *ptr = (char *) valloc(rawlen + datalen);
 #else
@@ -122,7 +333,11 @@ static ceph::spinlock debug_lock;
 
     static void operator delete(void *ptr) {
       raw_combined *raw = (raw_combined *)ptr;
-      aligned_free((void *)raw->data);
+      if (raw->pool) {
+	raw->pool->free(raw->data, raw->pool_class);
+      } else {
+	aligned_free((void *)raw->data);
+      }
     }
   };
 
@@ -2030,7 +2245,8 @@ __u32 buffer::list::crc32c(__u32 crc) const
 	   * http://crcutil.googlecode.com/files/crc-doc.1.0.pdf
 	   * note, u for our crc32c implementation is 0
 	   */
-	  crc = ccrc.second ^ ceph_crc32c(ccrc.first ^ crc, NULL, node.length());
+	  crc = ceph_crc32c_combine(ccrc.first ^ crc, ccrc.second,
+				    node.length());
 	  cache_adjusts++;
 	}
       } else {
@@ -11,6 +11,10 @@
 #include "common/crc32c_aarch64.h"
 #include "common/crc32c_ppc.h"
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 /*
  * choose best implementation based on the CPU architecture.
  */
@@ -213,8 +217,89 @@ static uint32_t crc_turbo_table[32][32] =
      0x00010000, 0x00020000, 0x00040000, 0x00080000, 0x00100000, 0x00200000, 0x00400000, 0x00800000}
 };
 
+#if defined(__x86_64__)
+/*
+ * With PCLMUL, appending zeros is a carry-less multiply by x^(8*len)
+ * modulo the crc polynomial.  The crc32 instruction does the modular
+ * reduction for us: for a and b in the bit reflected form crcs are
+ * kept in,
+ *
+ *   crc32q(0, clmul(a, b)) = a * b * x^33 mod P
+ *
+ * so we keep a table of x^(8*2^k - 33) and need one multiply per set
+ * bit of len.  The bytes below 8 are cheaper to feed through crc32
+ * directly, which also keeps every exponent in the table positive.
+ */
+static constexpr uint32_t crc32c_poly = 0x82f63b78;
+
+static constexpr uint32_t crc32c_multmodp(uint32_t a, uint32_t b)
+{
+  uint32_t m = 1u << 31;
+  uint32_t p = 0;
+  for (;;) {
+    if (a & m) {
+      p ^= b;
+      if ((a & (m - 1)) == 0)
+        break;
+    }
+    m >>= 1;
+    b = b & 1 ? (b >> 1) ^ crc32c_poly : b >> 1;
+  }
+  return p;
+}
+
+// x^e mod P
+static constexpr uint32_t crc32c_xpow(uint64_t e)
+{
+  uint32_t r = 1u << 31;
+  uint32_t sq = 1u << 30;
+  for (; e; e >>= 1) {
+    if (e & 1)
+      r = crc32c_multmodp(r, sq);
+    sq = crc32c_multmodp(sq, sq);
+  }
+  return r;
+}
+
+struct crc32c_shift_table {
+  uint32_t val[32] = {};
+  constexpr crc32c_shift_table() {
+    for (int k = 3; k < 32; k++) {
+      val[k] = crc32c_xpow((8ull << k) - 33);
+    }
+  }
+};
+static constexpr crc32c_shift_table crc_shift_table;
+
+__attribute__((target("pclmul,sse4.2")))
+static uint32_t ceph_crc32c_zeros_clmul(uint32_t crc, unsigned len)
+{
+  if (len & 4)
+    crc = _mm_crc32_u32(crc, 0);
+  if (len & 2)
+    crc = _mm_crc32_u16(crc, 0);
+  if (len & 1)
+    crc = _mm_crc32_u8(crc, 0);
+  len >>= 3;
+  for (int k = 3; len != 0; len >>= 1, k++) {
+    if (len & 1) {
+      __m128i p = _mm_clmulepi64_si128(_mm_cvtsi32_si128(crc),
+				       _mm_cvtsi32_si128(crc_shift_table.val[k]),
+				       0);
+      crc = _mm_crc32_u64(0, _mm_cvtsi128_si64(p));
+    }
+  }
+  return crc;
+}
+#endif
+
 uint32_t ceph_crc32c_zeros(uint32_t crc, unsigned len)
 {
+#if defined(__x86_64__)
+  if (ceph_arch_intel_pclmul && ceph_arch_intel_sse42) {
+    return ceph_crc32c_zeros_clmul(crc, len);
+  }
+#endif
   int range = 0;
   unsigned remainder = len & 15;
   len = len >> 4;
@@ -238,3 +323,8 @@ uint32_t ceph_crc32c_zeros(uint32_t crc, unsigned len)
     crc = ceph_crc32c(crc, nullptr, remainder);
   return crc;
 }
+
+uint32_t ceph_crc32c_combine(uint32_t crc_a, uint32_t crc_b, unsigned length_b)
+{
+  return ceph_crc32c_zeros(crc_a, length_b) ^ crc_b;
+}
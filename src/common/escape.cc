@@ -251,11 +251,51 @@ void escape_json_attr(const char *buf, size_t src_len, char *out)
 	*o = '\0';
 }
 
+static inline bool json_needs_escape(unsigned char c)
+{
+  return c == '"' || c == '\\' || c < 0x20 || c == 0x7f;
+}
+
+// check 8 characters at once: true if any of them is a quote, backslash
+// or control character.  bytes >= 0x80 (utf-8) are passed through.
+static inline bool json_needs_escape8(const char *p)
+{
+  constexpr uint64_t ones = 0x0101010101010101ull;
+  constexpr uint64_t highs = 0x8080808080808080ull;
+  uint64_t w;
+  memcpy(&w, p, sizeof(w));
+  auto has_zero = [](uint64_t v) {
+    return (v - ones) & ~v & highs;
+  };
+  return ((w - ones * 0x20) & ~w & highs) ||  // < 0x20
+    has_zero(w ^ (ones * '"')) ||
+    has_zero(w ^ (ones * '\\')) ||
+    has_zero(w ^ (ones * 0x7f));
+}
+
 std::ostream& operator<<(std::ostream& out, const json_stream_escaper& e)
 {
   boost::optional<hex_formatter> fmt;
 
-  for (unsigned char c : e.str) {
+  const char *p = e.str.data();
+  const char *end = p + e.str.size();
+  while (p != end) {
+    // most strings need little or no escaping: write out the run of
+    // characters up to the next one that does in one go
+    const char *run = p;
+    while (end - p >= 8 && !json_needs_escape8(p)) {
+      p += 8;
+    }
+    while (p != end && !json_needs_escape(*p)) {
+      ++p;
+    }
+    if (p != run) {
+      out.write(run, p - run);
+    }
+    if (p == end) {
+      break;
+    }
+    unsigned char c = *p++;
     switch (c) {
     case '"':
       out << DBL_QUOTE_JESCAPE;
@@ -271,14 +311,10 @@ std::ostream& operator<<(std::ostream& out, const json_stream_escaper& e)
       break;
     default:
       // Escape control characters.
-      if ((c < 0x20) || (c == 0x7f)) {
-        if (!fmt) {
-          fmt.emplace(out); // enable hex formatting
-        }
-        out << "\\u" << std::setw(4) << static_cast<unsigned int>(c);
-      } else {
-        out << c;
+      if (!fmt) {
+        fmt.emplace(out); // enable hex formatting
       }
+      out << "\\u" << std::setw(4) << static_cast<unsigned int>(c);
       break;
     }
   }
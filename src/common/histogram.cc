@@ -12,6 +12,8 @@
  *
  */
 
+#include <algorithm>
+
 #include "common/histogram.h"
 #include "common/Formatter.h"
 
@@ -49,6 +51,36 @@ void pow2_hist_t::generate_test_instances(std::list<pow2_hist_t*>& ls)
   ls.back()->h.push_back(2);
 }
 
+namespace {
+// bin i holds the values v with cbits(v) == i, i.e. v < 2^i
+template <typename Bins>
+uint64_t percentile_upper_bound(const Bins& h, unsigned pct)
+{
+  uint64_t total = 0;
+  for (auto count : h) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  uint64_t want = (total * std::min(pct, 100u) + 99) / 100;
+  uint64_t sum = 0;
+  unsigned bin = 0;
+  for (; bin + 1 < h.size(); ++bin) {
+    sum += h[bin];
+    if (sum >= want) {
+      break;
+    }
+  }
+  return (1ull << bin) - 1;
+}
+}
+
+int32_t pow2_hist_t::get_percentile_upper_bound(unsigned pct) const
+{
+  return percentile_upper_bound(h, pct);
+}
+
 void pow2_hist_t::decay(int bits)
 {
   for (std::vector<int32_t>::iterator p = h.begin(); p != h.end(); ++p) {
@@ -56,3 +88,21 @@ void pow2_hist_t::decay(int bits)
   }
   _contract();
 }
+
+// -- pow2_hist_fixed_t --
+uint32_t pow2_hist_fixed_t::get_percentile_upper_bound(unsigned pct) const
+{
+  return percentile_upper_bound(h, pct);
+}
+
+void pow2_hist_fixed_t::dump(ceph::Formatter *f) const
+{
+  unsigned size = h.size();
+  while (size > 0 && h[size - 1] == 0)
+    --size;
+  f->open_array_section("histogram");
+  for (unsigned i = 0; i < size; ++i)
+    f->dump_unsigned("count", h[i]);
+  f->close_section();
+  f->dump_unsigned("upper_bound", 1ull << size);
+}
@@ -13,6 +13,8 @@
 #ifndef CEPH_HISTOGRAM_H
 #define CEPH_HISTOGRAM_H
 
+#include <algorithm>
+#include <array>
 #include <list>
 #include "include/encoding.h"
 #include "include/intarith.h"
@@ -115,6 +117,12 @@ public:
     return 1 << h.size();
   }
 
+  /// get the largest value the bin holding the given percentile may hold
+  ///
+  /// @param pct [in] percentile (0..100)
+  /// @return upper bound of the bin, or 0 if the histogram is empty
+  int32_t get_percentile_upper_bound(unsigned pct) const;
+
   /// decay histogram by N bits (default 1, for a halflife)
   void decay(int bits = 1);
 
@@ -125,4 +133,41 @@ public:
 };
 WRITE_CLASS_ENCODER(pow2_hist_t)
 
+/**
+ * power of 2 histogram with a fixed number of bins
+ *
+ * Same binning as pow2_hist_t, but it never allocates, so it can be
+ * updated for every sample on a hot path.  Values that would land past
+ * the last bin are counted in it.
+ */
+struct pow2_hist_fixed_t {
+  static constexpr unsigned NUM_BINS = 32;
+  std::array<uint32_t, NUM_BINS> h = {};
+
+  void clear() {
+    h.fill(0);
+  }
+  bool empty() const {
+    for (auto count : h) {
+      if (count)
+	return false;
+    }
+    return true;
+  }
+  void add(uint32_t v) {
+    h[std::min<unsigned>(cbits(v), NUM_BINS - 1)]++;
+  }
+  /// decay histogram by N bits (default 1, for a halflife)
+  void decay(int bits = 1) {
+    for (auto& count : h) {
+      count >>= bits;
+    }
+  }
+
+  /// see pow2_hist_t::get_percentile_upper_bound()
+  uint32_t get_percentile_upper_bound(unsigned pct) const;
+
+  void dump(ceph::Formatter *f) const;
+};
+
 #endif /* CEPH_HISTOGRAM_H */
@@ -15,6 +15,8 @@
 #ifndef MAPCACHER_H
 #define MAPCACHER_H
 
+#include <vector>
+
 #include "include/Context.h"
 #include "common/sharedptr_registry.hpp"
 
@@ -60,6 +62,27 @@ public:
     std::pair<K, V> *next    ///< [out] first key after key
     ) = 0; ///< @return 0 on success, -ENOENT if there is no next
 
+  /// Appends up to max keys following key, in order
+  virtual int get_next_n(
+    const K &key,       ///< [in] key after which to get next
+    unsigned max,       ///< [in] maximum number of keys to get
+    std::vector<std::pair<K, V>> *next ///< [out] keys after key
+    ) { ///< @return 0 on success, -ENOENT if there is no next
+    K pos = key;
+    for (unsigned i = 0; i < max; ++i) {
+      std::pair<K, V> n;
+      int r = get_next(pos, &n);
+      if (r == -ENOENT) {
+	break;
+      } else if (r < 0) {
+	return r;
+      }
+      pos = n.first;
+      next->push_back(std::move(n));
+    }
+    return next->empty() ? -ENOENT : 0;
+  }
+
   virtual int get_next_or_current(
     const K &key,       ///< [in] key at-which-or-after to get
     std::pair<K, V> *next_or_current
@@ -126,6 +149,65 @@ public:
     return -EINVAL;
   } ///< @return error value, 0 on success, -ENOENT if no more entries
 
+  /**
+   * Fetch up to max key/value pairs after specified key
+   *
+   * Same result as calling get_next() repeatedly, but the store is
+   * asked for a batch of keys at a time.
+   */
+  int get_next_n(
+    K key,               ///< [in] key after which to get next
+    unsigned max,        ///< [in] maximum number of keys to get
+    std::vector<std::pair<K, V>> *next ///< [out] next keys, in order
+    ) {
+    next->clear();
+    while (true) {
+      // pin the in progress entries before reading the store so that none
+      // can be applied and dropped from the cache between the two reads
+      std::vector<std::pair<K, VPtr> > cached;
+      for (std::pair<K, VPtr> c; in_progress.get_next(
+	     cached.empty() ? key : cached.back().first, &c); ) {
+	cached.push_back(std::move(c));
+      }
+      std::vector<std::pair<K, V>> store;
+      unsigned want = max - next->size();
+      int r = driver->get_next_n(key, want, &store);
+      if (r < 0 && r != -ENOENT) {
+	return r;
+      }
+      // a full batch may stop short of the store's end: cached entries
+      // past its last key have to wait for the next batch
+      bool store_done = store.size() < want;
+      auto s = store.begin();
+      auto c = cached.begin();
+      while (next->size() < max) {
+	bool use_cached = c != cached.end() &&
+	  (store_done || c->first <= store.back().first) &&
+	  (s == store.end() || c->first <= s->first);
+	if (use_cached) {
+	  if (s != store.end() && s->first == c->first) {
+	    ++s;
+	  }
+	  if (*c->second) {
+	    next->emplace_back(c->first, c->second->get());
+	  } // else: value was cached as removed
+	  key = c->first;
+	  ++c;
+	} else if (s != store.end()) {
+	  key = s->first;
+	  next->push_back(std::move(*s));
+	  ++s;
+	} else {
+	  break;
+	}
+      }
+      if (store_done || next->size() == max) {
+	return next->empty() ? -ENOENT : 0;
+      }
+      // some of the batch was cached as removed, keep going from its end
+    }
+  }
+
   /// Adds operation setting keys to Transaction
   void set_keys(
     const std::map<K, V> &keys,  ///< [in] keys/values to std::set
@@ -179,6 +179,26 @@ PerfCounters::~PerfCounters()
 {
 }
 
+void PerfCounters::add(perf_counter_data_any_d& data, uint64_t amt)
+{
+  if (data.shard_lines) {
+    auto& sh = data.shard(ceph::perf_counters::pick_shard());
+    if (data.type & PERFCOUNTER_LONGRUNAVG) {
+      sh.avgcount++;
+      sh.u64 += amt;
+      sh.avgcount2++;
+    } else {
+      sh.u64.fetch_add(amt, std::memory_order_relaxed);
+    }
+  } else if (data.type & PERFCOUNTER_LONGRUNAVG) {
+    data.avgcount++;
+    data.u64 += amt;
+    data.avgcount2++;
+  } else {
+    data.u64 += amt;
+  }
+}
+
 void PerfCounters::inc(int idx, uint64_t amt)
 {
 #ifndef WITH_SEASTAR
@@ -191,13 +211,7 @@ void PerfCounters::inc(int idx, uint64_t amt)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_U64))
     return;
-  if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt;
-    data.avgcount2++;
-  } else {
-    data.u64 += amt;
-  }
+  add(data, amt);
 }
 
 void PerfCounters::dec(int idx, uint64_t amt)
@@ -213,7 +227,11 @@ void PerfCounters::dec(int idx, uint64_t amt)
   ceph_assert(!(data.type & PERFCOUNTER_LONGRUNAVG));
   if (!(data.type & PERFCOUNTER_U64))
     return;
-  data.u64 -= amt;
+  if (data.shard_lines) {
+    data.shard(ceph::perf_counters::pick_shard()).u64 -= amt;
+  } else {
+    data.u64 -= amt;
+  }
 }
 
 void PerfCounters::set(int idx, uint64_t amt)
@@ -231,7 +249,21 @@ void PerfCounters::set(int idx, uint64_t amt)
 
   ANNOTATE_BENIGN_RACE_SIZED(&data.u64, sizeof(data.u64),
                              "perf counter atomic");
-  if (data.type & PERFCOUNTER_LONGRUNAVG) {
+  if (data.shard_lines) {
+    // not meant for hot paths: other shards are cleared non-atomically
+    // with respect to concurrent inc()s
+    for (unsigned s = 1; s < ceph::perf_counters::num_shards(); ++s) {
+      data.shard(s).u64 = 0;
+    }
+    auto& sh = data.shard(0);
+    if (data.type & PERFCOUNTER_LONGRUNAVG) {
+      sh.avgcount++;
+      sh.u64 = amt;
+      sh.avgcount2++;
+    } else {
+      sh.u64 = amt;
+    }
+  } else if (data.type & PERFCOUNTER_LONGRUNAVG) {
     data.avgcount++;
     data.u64 = amt;
     data.avgcount2++;
@@ -252,7 +284,7 @@ uint64_t PerfCounters::get(int idx) const
   const perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_U64))
     return 0;
-  return data.u64;
+  return data.read_u64();
 }
 
 void PerfCounters::tinc(int idx, utime_t amt)
@@ -267,13 +299,7 @@ void PerfCounters::tinc(int idx, utime_t amt)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return;
-  if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt.to_nsec();
-    data.avgcount2++;
-  } else {
-    data.u64 += amt.to_nsec();
-  }
+  add(data, amt.to_nsec());
 }
 
 void PerfCounters::tinc(int idx, ceph::timespan amt)
@@ -288,13 +314,7 @@ void PerfCounters::tinc(int idx, ceph::timespan amt)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return;
-  if (data.type & PERFCOUNTER_LONGRUNAVG) {
-    data.avgcount++;
-    data.u64 += amt.count();
-    data.avgcount2++;
-  } else {
-    data.u64 += amt.count();
-  }
+  add(data, amt.count());
 }
 
 void PerfCounters::tset(int idx, utime_t amt)
@@ -309,9 +329,16 @@ void PerfCounters::tset(int idx, utime_t amt)
   perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return;
-  data.u64 = amt.to_nsec();
   if (data.type & PERFCOUNTER_LONGRUNAVG)
     ceph_abort();
+  if (data.shard_lines) {
+    for (unsigned s = 1; s < ceph::perf_counters::num_shards(); ++s) {
+      data.shard(s).u64 = 0;
+    }
+    data.shard(0).u64 = amt.to_nsec();
+  } else {
+    data.u64 = amt.to_nsec();
+  }
 }
 
 utime_t PerfCounters::tget(int idx) const
@@ -326,7 +353,7 @@ utime_t PerfCounters::tget(int idx) const
   const perf_counter_data_any_d& data(m_data[idx - m_lower_bound - 1]);
   if (!(data.type & PERFCOUNTER_TIME))
     return utime_t();
-  uint64_t v = data.u64;
+  uint64_t v = data.read_u64();
   return utime_t(v / 1000000000ull, v % 1000000000ull);
 }
 
@@ -493,7 +520,7 @@ void PerfCounters::dump_formatted_generic(Formatter *f, bool schema,
         d->histogram->dump_formatted(f);
         f->close_section();
       } else {
-	uint64_t v = d->u64;
+	uint64_t v = d->read_u64();
 	if (d->type & PERFCOUNTER_U64) {
 	  f->dump_unsigned(d->name, v);
 	} else if (d->type & PERFCOUNTER_TIME) {
@@ -618,6 +645,20 @@ void PerfCountersBuilder::add_impl(
   data.histogram = std::move(histogram);
 }
 
+void PerfCountersBuilder::set_sharded(int idx)
+{
+  ceph_assert(idx > m_perf_counters->m_lower_bound);
+  ceph_assert(idx < m_perf_counters->m_upper_bound);
+  PerfCounters::perf_counter_data_any_d
+    &data(m_perf_counters->m_data[idx - m_perf_counters->m_lower_bound - 1]);
+  ceph_assert(data.type & (PERFCOUNTER_COUNTER | PERFCOUNTER_LONGRUNAVG));
+  if (data.histogram) {
+    data.histogram->set_sharded();
+  } else {
+    m_sharded.push_back(idx);
+  }
+}
+
 PerfCounters *PerfCountersBuilder::create_perf_counters()
 {
   PerfCounters::perf_counter_data_vec_t::const_iterator d = m_perf_counters->m_data.begin();
@@ -627,6 +668,25 @@ PerfCounters *PerfCountersBuilder::create_perf_counters()
     ceph_assert(d->type & (PERFCOUNTER_U64 | PERFCOUNTER_TIME));
   }
 
+  if (!m_sharded.empty()) {
+    // the copies of one cpu are packed together, and padded to whole
+    // cache lines so that no two cpus write to the same line
+    const unsigned stride =
+      (m_sharded.size() + PerfCounters::SHARD_SLOTS_PER_LINE - 1) /
+      PerfCounters::SHARD_SLOTS_PER_LINE;
+    m_perf_counters->m_shard_lines.reset(
+      new PerfCounters::perf_counter_shard_line_d[
+	stride * ceph::perf_counters::num_shards()]);
+    for (unsigned i = 0; i < m_sharded.size(); ++i) {
+      auto& data = m_perf_counters->m_data[
+	m_sharded[i] - m_perf_counters->m_lower_bound - 1];
+      ceph_assert(data.shard_lines == nullptr);
+      data.shard_lines = m_perf_counters->m_shard_lines.get();
+      data.shard_slot = i;
+      data.shard_stride = stride;
+    }
+  }
+
   PerfCounters *ret = m_perf_counters;
   m_perf_counters = NULL;
   return ret;
@@ -23,6 +23,7 @@
 #include <atomic>
 #include <cstdint>
 
+#include "common/perf_counters_shard.h"
 #include "common/perf_histogram.h"
 #include "include/utime.h"
 #include "include/common_fwd.h"
@@ -113,6 +114,12 @@ public:
     prio_default = prio_;
   }
 
+  /// Keep a per-cpu copy of a hot counter, averaged counter or histogram
+  /// that many threads update concurrently; the copies are only summed
+  /// when the counter is read.  Not for gauges: those are set(), not
+  /// incremented.
+  void set_sharded(int key);
+
   PerfCounters* create_perf_counters();
 private:
   PerfCountersBuilder(const PerfCountersBuilder &rhs);
@@ -124,6 +131,7 @@ private:
   PerfCounters *m_perf_counters;
 
   int prio_default = 0;
+  std::vector<int> m_sharded;
 };
 
 /*
@@ -154,6 +162,18 @@ private:
 class PerfCounters
 {
 public:
+  /** One cpu's copy of a sharded counter, see set_sharded(). */
+  struct alignas(32) perf_counter_shard_d {
+    std::atomic<uint64_t> u64 = { 0 };
+    std::atomic<uint64_t> avgcount = { 0 };
+    std::atomic<uint64_t> avgcount2 = { 0 };
+  };
+  /** Copies of the sharded counters of one cpu are packed in cache lines. */
+  static constexpr unsigned SHARD_SLOTS_PER_LINE = 4;
+  struct alignas(128) perf_counter_shard_line_d {
+    perf_counter_shard_d slot[SHARD_SLOTS_PER_LINE];
+  };
+
   /** Represents a PerfCounters data element. */
   struct perf_counter_data_any_d {
     perf_counter_data_any_d()
@@ -169,7 +189,7 @@ public:
         nick(other.nick),
 	 type(other.type),
 	 unit(other.unit),
-	 u64(other.u64.load()) {
+	 u64(other.read_u64()) {
       auto a = other.read_avg();
       u64 = a.first;
       avgcount = a.second;
@@ -189,6 +209,17 @@ public:
     std::atomic<uint64_t> avgcount = { 0 };
     std::atomic<uint64_t> avgcount2 = { 0 };
     std::unique_ptr<PerfHistogram<>> histogram;
+    // set for sharded counters, whose values live in the per-cpu slots
+    // instead of the fields above.  the copy constructor folds the slots
+    // back into a plain counter.
+    perf_counter_shard_line_d *shard_lines = nullptr;
+    uint32_t shard_slot = 0;
+    uint32_t shard_stride = 0;  // lines per cpu
+
+    perf_counter_shard_d& shard(unsigned s) const {
+      return shard_lines[s * shard_stride + shard_slot / SHARD_SLOTS_PER_LINE]
+	.slot[shard_slot % SHARD_SLOTS_PER_LINE];
+    }
 
     void reset()
     {
@@ -196,16 +227,53 @@ public:
 	    u64 = 0;
 	    avgcount = 0;
 	    avgcount2 = 0;
+	    if (shard_lines) {
+	      for (unsigned s = 0; s < ceph::perf_counters::num_shards(); ++s) {
+		shard(s).u64 = 0;
+		shard(s).avgcount = 0;
+		shard(s).avgcount2 = 0;
+	      }
+	    }
       }
       if (histogram) {
         histogram->reset();
       }
     }
 
+    uint64_t read_u64() const {
+      if (!shard_lines) {
+	return u64;
+      }
+      uint64_t sum = 0;
+      for (unsigned s = 0; s < ceph::perf_counters::num_shards(); ++s) {
+	sum += shard(s).u64.load(std::memory_order_relaxed);
+      }
+      return sum;
+    }
+
     // read <sum, count> safely by making sure the post- and pre-count
     // are identical; in other words the whole loop needs to be run
-    // without any intervening calls to inc, set, or tinc.
+    // without any intervening calls to inc, set, or tinc.  sharded
+    // counters do this per shard.
     std::pair<uint64_t,uint64_t> read_avg() const {
+      if (!shard_lines) {
+	return read_avg(u64, avgcount, avgcount2);
+      }
+      std::pair<uint64_t,uint64_t> ret = { 0, 0 };
+      for (unsigned s = 0; s < ceph::perf_counters::num_shards(); ++s) {
+	auto& sh = shard(s);
+	auto a = read_avg(sh.u64, sh.avgcount, sh.avgcount2);
+	ret.first += a.first;
+	ret.second += a.second;
+      }
+      return ret;
+    }
+
+  private:
+    static std::pair<uint64_t,uint64_t> read_avg(
+      const std::atomic<uint64_t>& u64,
+      const std::atomic<uint64_t>& avgcount,
+      const std::atomic<uint64_t>& avgcount2) {
       uint64_t sum, count;
       do {
 	count = avgcount2;
@@ -277,6 +345,7 @@ private:
 	     int lower_bound, int upper_bound);
   PerfCounters(const PerfCounters &rhs);
   PerfCounters& operator=(const PerfCounters &rhs);
+  static void add(perf_counter_data_any_d& data, uint64_t amt);
   void dump_formatted_generic(ceph::Formatter *f, bool schema, bool histograms,
                               bool dump_labeled,
                               const std::string &counter = "") const;
@@ -297,6 +366,8 @@ private:
 #endif
 
   perf_counter_data_vec_t m_data;
+  /// per-cpu copies of the sharded counters, see set_sharded()
+  std::unique_ptr<perf_counter_shard_line_d[]> m_shard_lines;
 
   friend class PerfCountersBuilder;
   friend class PerfCountersCollectionImpl;
@@ -0,0 +1,49 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace ceph::perf_counters {
+
+/// Upper bound on the number of copies kept of a sharded counter.
+inline constexpr unsigned max_shards = 16;
+
+/// \brief Number of shards of sharded counters and histograms.
+///
+/// One per cpu, rounded up to a power of two and capped at max_shards;
+/// cpus beyond that share shards.
+inline unsigned num_shards()
+{
+  static const unsigned n = std::bit_ceil(
+    std::clamp(std::thread::hardware_concurrency(), 1u, max_shards));
+  return n;
+}
+
+/// \brief Shard the calling thread should update.
+///
+/// This is the cpu we are running on where the platform can tell us
+/// cheaply (sched_getcpu() is served from the vdso or rseq area, not by a
+/// syscall), otherwise a shard picked round robin when the thread first
+/// gets here.  Either way two threads may land on the same shard, so
+/// shards are still updated atomically; they just rarely contend.
+inline unsigned pick_shard()
+{
+#ifdef __linux__
+  if (int cpu = sched_getcpu(); cpu >= 0) {
+    return cpu & (num_shards() - 1);
+  }
+#endif
+  static std::atomic<unsigned> next = {0};
+  thread_local const unsigned mine = next++;
+  return mine & (num_shards() - 1);
+}
+
+} // namespace ceph::perf_counters
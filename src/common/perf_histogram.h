@@ -20,6 +20,7 @@
 #include <memory>
 
 #include "common/Formatter.h"
+#include "common/perf_counters_shard.h"
 #include "include/int_types.h"
 #include "include/ceph_assert.h"
 
@@ -69,6 +70,9 @@ protected:
 /// dimension) and processing latency (second dimension). Creating standard
 /// histogram out of such multidimensional one is trivial and requires summing
 /// values across dimensions we're not interested in.
+///
+/// A histogram fed from many threads can be sharded with set_sharded(): every
+/// cpu then bumps its own copy of the counters, and readers sum the copies.
 template <int DIM = 2>
 class PerfHistogram : public PerfHistogramCommon {
 public:
@@ -86,24 +90,27 @@ public:
       m_axes_config[i++] = ac;
     }
 
-    m_rawData.reset(new std::atomic<uint64_t>[get_raw_size()] {});
+    allocate(1);
   }
 
   /// Copy from other histogram object
   PerfHistogram(const PerfHistogram &other)
       : m_axes_config(other.m_axes_config) {
-    int64_t size = get_raw_size();
-    m_rawData.reset(new std::atomic<uint64_t>[size] {});
-    for (int64_t i = 0; i < size; i++) {
-      m_rawData[i] = other.m_rawData[i].load();
+    allocate(other.m_shards);
+    for (int64_t i = 0; i < m_shards * m_stride; i++) {
+      raw(i) = other.raw(i).load();
     }
   }
 
+  /// Keep one set of counters per cpu; drops any value counted so far
+  void set_sharded() {
+    allocate(ceph::perf_counters::num_shards());
+  }
+
   /// Set all histogram values to 0
   void reset() {
-    auto size = get_raw_size();
-    for (auto i = size; --i >= 0;) {
-      m_rawData[i] = 0;
+    for (int64_t i = 0; i < m_shards * m_stride; i++) {
+      raw(i) = 0;
     }
   }
 
@@ -111,21 +118,21 @@ public:
   template <typename... T>
   void inc(T... axis) {
     auto index = get_raw_index_for_value(axis...);
-    m_rawData[index]++;
+    shard_raw(index).fetch_add(1, std::memory_order_relaxed);
   }
 
   /// Increase counter for given axis buckets by one
   template <typename... T>
   void inc_bucket(T... bucket) {
     auto index = get_raw_index_for_bucket(bucket...);
-    m_rawData[index]++;
+    shard_raw(index).fetch_add(1, std::memory_order_relaxed);
   }
 
   /// Read value from given bucket
   template <typename... T>
   uint64_t read_bucket(T... bucket) const {
     auto index = get_raw_index_for_bucket(bucket...);
-    return m_rawData[index];
+    return read_raw(index);
   }
 
   /// Dump data to a Formatter object
@@ -142,13 +149,53 @@ public:
   }
 
 protected:
+  /// Raw data is allocated in whole cache lines, so that the counters of
+  /// one shard never share a line with those of another.
+  static constexpr int64_t RAW_PER_LINE = 16;
+  struct alignas(128) raw_line_t {
+    std::atomic<uint64_t> v[RAW_PER_LINE];
+  };
+
   /// Raw data stored as linear space, internal indexes are calculated on
-  /// demand.
-  std::unique_ptr<std::atomic<uint64_t>[]> m_rawData;
+  /// demand.  Shard s holds its counters at [s * m_stride, (s + 1) * m_stride).
+  std::unique_ptr<raw_line_t[]> m_rawData;
+  int64_t m_shards = 1;
+  int64_t m_stride = 0;
 
   /// Configuration of axes
   std::array<axis_config_d, DIM> m_axes_config;
 
+  void allocate(int64_t shards) {
+    m_shards = shards;
+    m_stride = get_raw_size();
+    if (m_shards > 1) {
+      m_stride = (m_stride + RAW_PER_LINE - 1) / RAW_PER_LINE * RAW_PER_LINE;
+    }
+    m_rawData.reset(
+      new raw_line_t[(m_shards * m_stride + RAW_PER_LINE - 1) / RAW_PER_LINE]);
+  }
+
+  std::atomic<uint64_t>& raw(int64_t i) const {
+    return m_rawData[i / RAW_PER_LINE].v[i % RAW_PER_LINE];
+  }
+
+  /// The calling cpu's copy of counter index
+  std::atomic<uint64_t>& shard_raw(int64_t index) const {
+    if (m_shards == 1) {
+      return raw(index);
+    }
+    return raw(ceph::perf_counters::pick_shard() * m_stride + index);
+  }
+
+  /// Counter index summed over all shards
+  uint64_t read_raw(int64_t index) const {
+    uint64_t ret = 0;
+    for (int64_t s = 0; s < m_shards; s++) {
+      ret += raw(s * m_stride + index).load(std::memory_order_relaxed);
+    }
+    return ret;
+  }
+
   /// Dump histogram counters to a formatter
   void dump_formatted_values(ceph::Formatter *f) const {
     visit_values([f](int) { f->open_array_section("values"); },
@@ -209,7 +256,7 @@ protected:
   void visit_values(FDE onDimensionEnter, FV onValue, FDL onDimensionLeave,
                     int level = 0, int startIndex = 0) const {
     if (level == DIM) {
-      onValue(m_rawData[startIndex]);
+      onValue(read_raw(startIndex));
       return;
     }
 
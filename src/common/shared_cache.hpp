@@ -46,44 +46,83 @@ public:
 private:
   using C = std::less<K>;
   using H = std::hash<K>;
-  ceph::unordered_map<K, typename std::list<std::pair<K, VPtr> >::iterator, H> contents;
-  std::list<std::pair<K, VPtr> > lru;
+  using lru_t = std::list<std::pair<K, VPtr> >;
+
+  /// a value handed out by the cache that may still be referenced
+  struct WeakRef {
+    WeakVPtr weak;
+    V *ptr;
+    /// where the cache's own ref sits in the lru, or lru.end() if none
+    typename lru_t::iterator lru_pos;
+  };
+  using weak_refs_t = std::map<K, WeakRef, C>;
+
+  lru_t lru;
+  weak_refs_t weak_refs;
+  /// exact key lookups, most of them, skip the ordered weak_refs search
+  ceph::unordered_map<K, typename weak_refs_t::iterator, H> index;
+
+  typename weak_refs_t::iterator find_ref(const K& key) {
+    auto i = index.find(key);
+    return i == index.end() ? weak_refs.end() : i->second;
+  }
 
-  std::map<K, std::pair<WeakVPtr, V*>, C> weak_refs;
+  typename weak_refs_t::iterator insert_ref(const K& key, const VPtr& val) {
+    auto i = weak_refs.emplace(key, WeakRef{val, val.get(), lru.end()}).first;
+    index.emplace(key, i);
+    return i;
+  }
+
+  void erase_ref(typename weak_refs_t::iterator i) {
+    ceph_assert(i->second.lru_pos == lru.end());
+    index.erase(i->first);
+    weak_refs.erase(i);
+  }
+
+  VPtr lru_pop_back() {
+    VPtr val = std::move(lru.back().second);
+    if (auto i = find_ref(lru.back().first); i != weak_refs.end()) {
+      i->second.lru_pos = lru.end();
+    }
+    lru.pop_back();
+    --size;
+    return val;
+  }
 
   void trim_cache(std::list<VPtr> *to_release) {
     while (size > max_size) {
-      to_release->push_back(lru.back().second);
-      lru_remove(lru.back().first);
+      to_release->push_back(lru_pop_back());
     }
   }
 
-  void lru_remove(const K& key) {
-    auto i = contents.find(key);
-    if (i == contents.end())
+  void lru_remove(typename weak_refs_t::iterator i) {
+    if (i == weak_refs.end() || i->second.lru_pos == lru.end())
       return;
-    lru.erase(i->second);
+    lru.erase(i->second.lru_pos);
+    i->second.lru_pos = lru.end();
     --size;
-    contents.erase(i);
   }
 
-  void lru_add(const K& key, const VPtr& val, std::list<VPtr> *to_release) {
-    auto i = contents.find(key);
-    if (i != contents.end()) {
-      lru.splice(lru.begin(), lru, i->second);
+  void lru_add(typename weak_refs_t::iterator i, const VPtr& val,
+	       std::list<VPtr> *to_release) {
+    auto& pos = i->second.lru_pos;
+    if (pos != lru.end()) {
+      if (pos != lru.begin()) {
+	lru.splice(lru.begin(), lru, pos);
+      }
     } else {
       ++size;
-      lru.push_front(make_pair(key, val));
-      contents[key] = lru.begin();
+      lru.emplace_front(i->first, val);
+      pos = lru.begin();
       trim_cache(to_release);
     }
   }
 
   void remove(const K& key, V *valptr) {
     std::lock_guard l{lock};
-    auto i = weak_refs.find(key);
-    if (i != weak_refs.end() && i->second.second == valptr) {
-      weak_refs.erase(i);
+    auto i = find_ref(key);
+    if (i != weak_refs.end() && i->second.ptr == valptr) {
+      erase_ref(i);
     }
     cond.notify_all();
   }
@@ -105,12 +144,11 @@ public:
       lock{ceph::make_mutex("SharedLRU::lock")},
       max_size(max_size),
       size(0), waiting(0) {
-    contents.rehash(max_size); 
+    index.rehash(max_size);
   }
   
   ~SharedLRU() {
-    contents.clear();
-    lru.clear();
+    clear();
     if (!weak_refs.empty()) {
       lderr(cct) << "leaked refs:\n";
       dump_weak_refs(*_dout);
@@ -139,8 +177,8 @@ public:
   void dump_weak_refs(std::ostream& out) {
     for (const auto& [key, ref] : weak_refs) {
       out << __func__ << " " << this << " weak_refs: "
-	  << key << " = " << ref.second
-	  << " with " << ref.first.use_count() << " refs"
+	  << key << " = " << ref.ptr
+	  << " with " << ref.weak.use_count() << " refs"
 	  << std::endl;
     }
   }
@@ -153,8 +191,7 @@ public:
       if (size == 0)
         break;
 
-      val = lru.back().second;
-      lru_remove(lru.back().first);
+      val = lru_pop_back();
     }
   }
 
@@ -162,11 +199,11 @@ public:
     VPtr val; // release any ref we have after we drop the lock
     {
       std::lock_guard l{lock};
-      auto i = weak_refs.find(key);
+      auto i = find_ref(key);
       if (i != weak_refs.end()) {
-	val = i->second.first.lock();
+	val = i->second.weak.lock();
+	lru_remove(i);
       }
-      lru_remove(key);
     }
   }
 
@@ -179,9 +216,9 @@ public:
       std::lock_guard l{lock};
       auto from_iter = weak_refs.lower_bound(from);
       auto to_iter = weak_refs.upper_bound(to);
-      for (auto i = from_iter; i != to_iter; ) {
-	vals.push_back(i->second.first.lock());
-	lru_remove((i++)->first);
+      for (auto i = from_iter; i != to_iter; ++i) {
+	vals.push_back(i->second.weak.lock());
+	lru_remove(i);
       }
     }
   }
@@ -191,12 +228,12 @@ public:
     VPtr val; // release any ref we have after we drop the lock
     {
       std::lock_guard l{lock};
-      auto i = weak_refs.find(key);
+      auto i = find_ref(key);
       if (i != weak_refs.end()) {
-	val = i->second.first.lock();
-        weak_refs.erase(i);
+	val = i->second.weak.lock();
+	lru_remove(i);
+	erase_ref(i);
       }
-      lru_remove(key);
     }
   }
 
@@ -229,8 +266,8 @@ public:
         if (i == weak_refs.end()) {
           --i;
         }
-        if (val = i->second.first.lock(); val) {
-          lru_add(i->first, val, &to_release);
+        if (val = i->second.weak.lock(); val) {
+          lru_add(i, val, &to_release);
           return true;
         } else {
           return false;
@@ -245,10 +282,10 @@ public:
     {
       std::lock_guard l{lock};
       VPtr next_val;
-      typename std::map<K, std::pair<WeakVPtr, V*>, C>::iterator i = weak_refs.upper_bound(key);
+      auto i = weak_refs.upper_bound(key);
 
       while (i != weak_refs.end() &&
-	     !(next_val = i->second.first.lock()))
+	     !(next_val = i->second.weak.lock()))
 	++i;
 
       if (i == weak_refs.end())
@@ -279,9 +316,9 @@ public:
       std::unique_lock l{lock};
       ++waiting;
       cond.wait(l, [this, &key, &val, &to_release] {
-        if (auto i = weak_refs.find(key); i != weak_refs.end()) {
-          if (val = i->second.first.lock(); val) {
-            lru_add(key, val, &to_release);
+        if (auto i = find_ref(key); i != weak_refs.end()) {
+          if (val = i->second.weak.lock(); val) {
+            lru_add(i, val, &to_release);
             return true;
           } else {
             return false;
@@ -299,9 +336,10 @@ public:
     std::list<VPtr> to_release;
     {
       std::unique_lock l{lock};
-      cond.wait(l, [this, &key, &val] {
-        if (auto i = weak_refs.find(key); i != weak_refs.end()) {
-          if (val = i->second.first.lock(); val) {
+      typename weak_refs_t::iterator i;
+      cond.wait(l, [this, &key, &val, &i] {
+        if (i = find_ref(key); i != weak_refs.end()) {
+          if (val = i->second.weak.lock(); val) {
             return true;
           } else {
             return false;
@@ -312,9 +350,9 @@ public:
       });
       if (!val) {
         val = VPtr{new V{}, Cleanup{this, key}};
-        weak_refs.insert(make_pair(key, make_pair(val, val.get())));
+        i = insert_ref(key, val);
       }
-      lru_add(key, val, &to_release);
+      lru_add(i, val, &to_release);
     }
     return val;
   }
@@ -346,12 +384,12 @@ public:
     VPtr val;
     std::list<VPtr> to_release;
     {
-      typename std::map<K, std::pair<WeakVPtr, V*>, C>::iterator actual;
+      typename weak_refs_t::iterator actual;
       std::unique_lock l{lock};
       cond.wait(l, [this, &key, &actual, &val] {
-	  actual = weak_refs.lower_bound(key);
-	  if (actual != weak_refs.end() && actual->first == key) {
-	    val = actual->second.first.lock();
+	  actual = find_ref(key);
+	  if (actual != weak_refs.end()) {
+	    val = actual->second.weak.lock();
 	    if (val) {
 	      return true;
 	    } else {
@@ -371,9 +409,9 @@ public:
 	  *existed = false;
 	}
 	val = VPtr(value, Cleanup(this, key));
-	weak_refs.insert(actual, make_pair(key, make_pair(val, value)));
+	actual = insert_ref(key, val);
       }
-      lru_add(key, val, &to_release);
+      lru_add(actual, val, &to_release);
     }
     return val;
   }
@@ -1625,6 +1625,33 @@ public:
       out[i] = rawout[i];
   }
 
+  /**
+   * map each of xs with the given rule, sharing one workspace
+   *
+   * out[i] is what do_rule(rule, xs[i], out[i], ...) would produce.
+   */
+  template<typename WeightVector>
+  void do_rule_batch(int rule, const std::vector<int>& xs,
+		     std::vector<std::vector<int>>& out, int maxout,
+		     const WeightVector& weight,
+		     uint64_t choose_args_index) const {
+    std::vector<int> rawout(std::size(xs) * maxout);
+    std::vector<int> rawlen(std::size(xs));
+    std::vector<char> work(crush_work_size(crush, maxout));
+    crush_init_workspace(crush, std::data(work));
+    crush_choose_arg_map arg_map = choose_args_get_with_fallback(
+      choose_args_index);
+    crush_do_rule_batch(crush, rule, std::data(xs), std::size(xs),
+			std::data(rawout), maxout, std::data(rawlen),
+			std::data(weight), std::size(weight),
+			std::data(work), arg_map.args);
+    out.resize(std::size(xs));
+    for (size_t i = 0; i < std::size(xs); i++) {
+      auto first = rawout.begin() + i * maxout;
+      out[i].assign(first, first + rawlen[i]);
+    }
+  }
+
   int _choose_type_stack(
     CephContext *cct,
     const std::vector<std::pair<int,int>>& stack,
@@ -28,6 +28,9 @@
 #define dprintk(args...) /* printf(args) */
 
 #define MIN(x, y) ((x) > (y) ? (y) : (x))
+
+/* straw2 items hashed per pass; bounds the on-stack hash buffer */
+#define CRUSH_STRAW2_HASH_CHUNK 64
 #define MAX(y, x) ((x) < (y) ? (y) : (x))
 
 /*
@@ -312,11 +315,9 @@ static inline __s32 *get_choose_arg_ids(const struct crush_bucket_straw2 *bucket
  * for reference, see the exponential distribution example at:  
  * https://en.wikipedia.org/wiki/Inverse_transform_sampling#Examples
  */
-static inline __s64 generate_exponential_distribution(int type, int x, int y, int z, 
-                                                      int weight)
+static inline __s64 generate_exponential_distribution(__u32 hash, int weight)
 {
-	unsigned int u = crush_hash32_3(type, x, y, z);
-	u &= 0xffff;
+	unsigned int u = hash & 0xffff;
 
 	/*
 	 * for some reason slightly less than 0x10000 produces
@@ -343,21 +344,35 @@ static int bucket_straw2_choose(const struct crush_bucket_straw2 *bucket,
 				int x, int r, const struct crush_choose_arg *arg,
                                 int position)
 {
-	unsigned int i, high = 0;
+	unsigned int i, j, n, high = 0;
 	__s64 draw, high_draw = 0;
+	__u32 hashes[CRUSH_STRAW2_HASH_CHUNK];
         __u32 *weights = get_choose_arg_weights(bucket, arg, position);
         __s32 *ids = get_choose_arg_ids(bucket, arg);
-	for (i = 0; i < bucket->h.size; i++) {
-                dprintk("weight 0x%x item %d\n", weights[i], ids[i]);
-		if (weights[i]) {
-			draw = generate_exponential_distribution(bucket->h.hash, x, ids[i], r, weights[i]);
-		} else {
-			draw = S64_MIN;
-		}
 
-		if (i == 0 || draw > high_draw) {
-			high = i;
-			high_draw = draw;
+	/*
+	 * hash a chunk of items in one pass (independent lanes, which
+	 * the compiler can vectorize), then do the table driven ln and
+	 * the division per item.  same draws, same order, same result.
+	 */
+	for (i = 0; i < bucket->h.size; i += n) {
+		n = MIN(bucket->h.size - i, CRUSH_STRAW2_HASH_CHUNK);
+		crush_hash32_3_vec(bucket->h.hash, x, (const __u32 *)ids + i,
+				   r, hashes, n);
+		for (j = 0; j < n; j++) {
+			dprintk("weight 0x%x item %d\n", weights[i + j],
+				ids[i + j]);
+			if (weights[i + j]) {
+				draw = generate_exponential_distribution(
+					hashes[j], weights[i + j]);
+			} else {
+				draw = S64_MIN;
+			}
+
+			if (i + j == 0 || draw > high_draw) {
+				high = i + j;
+				high_draw = draw;
+			}
 		}
 	}
 
@@ -2050,3 +2065,55 @@ int crush_do_rule(const struct crush_map *map,
 			choose_args);
 	}
 }
+
+/**
+ * crush_do_rule_batch - map many inputs with the same rule
+ * @map: the crush_map
+ * @ruleno: the rule id
+ * @x: hash inputs
+ * @num_x: number of inputs
+ * @result: num_x result vectors of result_max items each
+ * @result_max: maximum result size
+ * @result_len: per input result size
+ * @weight: weight vector (for map leaves)
+ * @weight_max: size of weight vector
+ * @cwin: workspace initialized by crush_init_workspace
+ * @choose_args: weights and ids for each known bucket
+ *
+ * Equivalent to calling crush_do_rule() for each input, but the rule
+ * lookup is done once, and the workspace and the buckets of the rule
+ * stay hot in cache across the inputs.
+ */
+void crush_do_rule_batch(const struct crush_map *map,
+			 int ruleno, const int *x, int num_x,
+			 int *result, int result_max, int *result_len,
+			 const __u32 *weight, int weight_max,
+			 void *cwin, const struct crush_choose_arg *choose_args)
+{
+	const struct crush_rule *rule;
+	int i, len;
+
+	if ((__u32)ruleno >= map->max_rules || !map->rules[ruleno]) {
+		dprintk(" bad ruleno %d\n", ruleno);
+		for (i = 0; i < num_x; i++)
+			result_len[i] = 0;
+		return;
+	}
+
+	rule = map->rules[ruleno];
+	for (i = 0; i < num_x; i++) {
+		if (rule_type_is_msr(rule->type)) {
+			len = crush_msr_do_rule(map, ruleno, x[i],
+						result + i * result_max,
+						result_max, weight, weight_max,
+						cwin, choose_args);
+		} else {
+			len = crush_do_rule_no_retry(map, ruleno, x[i],
+						     result + i * result_max,
+						     result_max, weight,
+						     weight_max, cwin,
+						     choose_args);
+		}
+		result_len[i] = len < 0 ? 0 : len;
+	}
+}
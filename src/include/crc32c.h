@@ -30,6 +30,24 @@ extern ceph_crc32c_func_t ceph_choose_crc32(void);
  */
 uint32_t ceph_crc32c_zeros(uint32_t crc, unsigned length);
 
+/**
+ * combine the crc32c of two adjacent buffers
+ *
+ * Given crc_a = crc32c(crc, A) and crc_b = crc32c(0, B), return
+ * crc32c(crc, A followed by B) without looking at either buffer.  This
+ * lets pieces of a larger buffer be checksummed independently, e.g. by
+ * different threads or out of a cache, and merged afterwards.  The cost
+ * is that of ceph_crc32c_zeros(), i.e. logarithmic in length_b.
+ *
+ * A chunk checksummed with another initial value v can be combined
+ * by passing crc_a ^ v instead of crc_a.
+ *
+ * @param crc_a crc of the first buffer
+ * @param crc_b crc of the second buffer, with initial value 0
+ * @param length_b length of the second buffer
+ */
+uint32_t ceph_crc32c_combine(uint32_t crc_a, uint32_t crc_b, unsigned length_b);
+
 /**
  * calculate crc32c
  *
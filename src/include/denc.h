@@ -404,6 +404,37 @@ struct denc_traits<T>
   }
 };
 
+// raw layout
+//
+// Types whose encoding is their in-memory image, so that a contiguous
+// run of them is encoded and decoded with one memcpy instead of element
+// by element.  This holds for the little-endian wire types on any host,
+// and for the plain integers on little-endian hosts; on big-endian
+// hosts those keep going through the per element byte swapping.  Other
+// trivially copyable types can opt in by specializing raw_layout, as
+// long as their denc is exactly their sizeof() bytes with no padding.
+namespace _denc {
+template<typename T>
+struct raw_layout : std::bool_constant<
+  is_any_of<underlying_type_t<T>, ceph_le64, ceph_le32, ceph_le16, uint8_t
+#ifndef _CHAR_IS_SIGNED
+	    , int8_t
+#endif
+	    > ||
+  (std::endian::native == std::endian::little &&
+   is_any_of<T, int16_t, uint16_t, int32_t, uint32_t, int64_t, uint64_t>)> {};
+
+template<typename T>
+inline constexpr bool raw_layout_v =
+  raw_layout<T>::value && std::is_trivially_copyable_v<T>;
+
+template<typename C>
+concept contiguous_container = requires(C& c, const C& cc, size_t n) {
+  { cc.data() } -> std::same_as<const typename C::value_type*>;
+  c.resize(n);
+};
+} // namespace _denc
+
 // varint
 //
 // high bit of each byte indicates another byte follows.
@@ -921,6 +952,10 @@ namespace _denc {
     using container = C<Ts...>;
     using T = typename Details::T;
 
+    // whether the elements can be copied in and out in one go
+    static constexpr bool raw_run =
+      _denc::raw_layout_v<T> && _denc::contiguous_container<container>;
+
   public:
     using traits = denc_traits<T>;
 
@@ -992,6 +1027,12 @@ namespace _denc {
     // nohead
     static void encode_nohead(const container& s, ceph::buffer::list::contiguous_appender& p,
 			      uint64_t f = 0) {
+      if constexpr (raw_run) {
+        if (const size_t len = s.size() * sizeof(T); len > 0) {
+          memcpy(p.get_pos_add(len), s.data(), len);
+        }
+        return;
+      }
       for (const T& e : s) {
         if constexpr (traits::featured) {
           denc(e, p, f);
@@ -1004,6 +1045,15 @@ namespace _denc {
 			      ceph::buffer::ptr::const_iterator& p,
 			      uint64_t f=0) {
       s.clear();
+      if constexpr (raw_run) {
+        const size_t len = num * sizeof(T);
+        const char *src = p.get_pos_add(len);
+        s.resize(num);
+        if (len > 0) {
+          memcpy(s.data(), src, len);
+        }
+        return;
+      }
       Details::reserve(s, num);
       while (num--) {
 	T t;
@@ -1016,6 +1066,15 @@ namespace _denc {
     decode_nohead(size_t num, container& s,
 		  ceph::buffer::list::const_iterator& p) {
       s.clear();
+      if constexpr (raw_run) {
+        const size_t len = num * sizeof(T);
+        if (len > p.get_remaining()) {
+          throw ceph::buffer::end_of_buffer();
+        }
+        s.resize(num);
+        p.copy(len, reinterpret_cast<char*>(s.data()));
+        return;
+      }
       Details::reserve(s, num);
       while (num--) {
 	T t;
@@ -1278,6 +1337,10 @@ public:
 
   static void encode(const container& s, ceph::buffer::list::contiguous_appender& p,
 		     uint64_t f = 0) {
+    if constexpr (_denc::raw_layout_v<T> && N > 0) {
+      memcpy(p.get_pos_add(N * sizeof(T)), s.data(), N * sizeof(T));
+      return;
+    }
     for (const auto& e : s) {
       if constexpr (traits::featured) {
         denc(e, p, f);
@@ -1288,6 +1351,10 @@ public:
   }
   static void decode(container& s, ceph::buffer::ptr::const_iterator& p,
 		     uint64_t f = 0) {
+    if constexpr (_denc::raw_layout_v<T> && N > 0) {
+      memcpy(s.data(), p.get_pos_add(N * sizeof(T)), N * sizeof(T));
+      return;
+    }
     for (auto& e : s)
       denc(e, p, f);
   }
@@ -1295,6 +1362,10 @@ public:
   static std::enable_if_t<!!sizeof(U) &&
 			  !need_contiguous>
   decode(container& s, ceph::buffer::list::const_iterator& p) {
+    if constexpr (_denc::raw_layout_v<T> && N > 0) {
+      p.copy(N * sizeof(T), reinterpret_cast<char*>(s.data()));
+      return;
+    }
     for (auto& e : s) {
       denc(e, p);
     }
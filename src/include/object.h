@@ -147,6 +147,14 @@ struct denc_traits<snapid_t> {
   }
 };
 
+// encoded as its val, so runs of snapids (e.g. SnapContext::snaps) can
+// be copied in one go where that is the in-memory layout as well
+namespace _denc {
+template<>
+struct raw_layout<snapid_t> : raw_layout<uint64_t> {};
+}
+static_assert(sizeof(snapid_t) == sizeof(uint64_t));
+
 inline std::ostream& operator<<(std::ostream& out, const snapid_t& s) {
   if (s == CEPH_NOSNAP)
     return out << "head";
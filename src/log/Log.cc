@@ -47,8 +47,11 @@ static void log_on_exit(void *p)
   delete (Log **)p;// Delete allocated pointer (not Log object, the pointer only!)
 }
 
+std::atomic<uint64_t> Log::next_id = 0;
+
 Log::Log(const SubsystemMap *s)
-  : m_indirect_this(nullptr),
+  : m_id(++next_id),
+    m_indirect_this(nullptr),
     m_subs(s),
     m_recent(DEFAULT_MAX_RECENT)
 {
@@ -63,6 +66,9 @@ Log::~Log()
   }
 
   ceph_assert(!is_started());
+  for (auto& q : m_thread_queues) {
+    q->detached = true;
+  }
   if (m_fd >= 0) {
     VOID_TEMP_FAILURE_RETRY(::close(m_fd));
     m_fd = -1;
@@ -247,14 +253,71 @@ void Log::stop_journald_logger()
   m_journald.reset();
 }
 
-void Log::submit_entry(Entry&& e)
+bool Log::ThreadQueue::try_push(const Entry& e)
 {
-  std::unique_lock lock(m_queue_mutex);
-  m_queue_mutex_holder = pthread_self();
+  auto t = tail.load(std::memory_order_relaxed);
+  if (t - head.load(std::memory_order_acquire) == slots.size()) {
+    return false;
+  }
+  slots[t % slots.size()] = std::make_unique<ConcreteEntry>(e);
+  // seq_cst: pairs with m_flusher_waiting, see Log::entry()
+  tail.store(t + 1);
+  return true;
+}
+
+Log::ThreadQueue* Log::_get_thread_queue()
+{
+  struct Queues {
+    ~Queues() { destructed = true; }
+    std::vector<std::pair<uint64_t, std::shared_ptr<ThreadQueue>>> v;
+    bool destructed = false;
+  };
+  static thread_local Queues queues;
+
+  if (unlikely(queues.destructed)) {
+    // logging from a thread_local destructor at thread exit
+    return nullptr;
+  }
+  for (auto& [id, q] : queues.v) {
+    if (id == m_id) {
+      return q.get();
+    }
+  }
+  // first entry of this thread for this Log; drop the queues of Logs
+  // that are gone while we are at it
+  std::erase_if(queues.v, [](auto& p) { return p.second->detached.load(); });
+  auto q = std::make_shared<ThreadQueue>(THREAD_QUEUE_SIZE);
+  {
+    std::scoped_lock lock(m_queue_mutex);
+    m_thread_queues.push_back(q);
+  }
+  queues.v.emplace_back(m_id, q);
+  return q.get();
+}
 
+void Log::submit_entry(Entry&& e)
+{
   if (unlikely(m_inject_segv))
     *(volatile int *)(0) = 0xdead;
 
+  auto q = _get_thread_queue();
+  if (q && !q->spilled.load(std::memory_order_relaxed)) {
+    // entries queued by all threads count against m_max_new
+    if (m_queued.fetch_add(1, std::memory_order_relaxed) <
+	  m_max_new.load(std::memory_order_relaxed) &&
+	q->try_push(e)) {
+      if (m_flusher_waiting.load()) {
+	std::scoped_lock lock(m_queue_mutex);
+	m_cond_flusher.notify_all();
+      }
+      return;
+    }
+    m_queued.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  std::unique_lock lock(m_queue_mutex);
+  m_queue_mutex_holder = pthread_self();
+
   // wait for flush to catch up
   while (is_started() &&
 	 m_new.size() > m_max_new) {
@@ -262,11 +325,103 @@ void Log::submit_entry(Entry&& e)
     m_cond_loggers.wait(lock);
   }
 
+  if (q) {
+    // keep using m_new until the flusher has taken the queue, so that
+    // later entries do not overtake this one
+    q->spilled = true;
+  }
+  ++m_spilled;
   m_new.emplace_back(std::move(e));
   m_cond_flusher.notify_all();
   m_queue_mutex_holder = 0;
 }
 
+bool Log::_have_new()
+{
+  if (!m_new.empty()) {
+    return true;
+  }
+  for (auto& q : m_thread_queues) {
+    if (q->head.load(std::memory_order_relaxed) != q->tail.load()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Move all new entries into t, merging the thread queues and m_new
+ * by timestamp.  The entries of each thread stay in submission order
+ * even if the wall clock steps back: a thread queue is drained in ring
+ * order, m_new in insertion order, and whatever a thread spilled into
+ * m_new is newer than everything still in its queue, so a spilled
+ * entry is held back until its owner's queue is drained, whatever the
+ * stamps say.
+ */
+void Log::_take_new(EntryVector& t)
+{
+  assert(t.empty());
+
+  struct Run {
+    ThreadQueue *q;
+    std::size_t pos, end;
+    const Entry::time& stamp() const {
+      return q->at(pos).m_stamp;
+    }
+  };
+  std::vector<Run> runs;
+  std::size_t queued = 0;
+  for (auto& q : m_thread_queues) {
+    auto pos = q->head.load(std::memory_order_relaxed);
+    auto end = q->tail.load(std::memory_order_acquire);
+    if (pos != end) {
+      runs.push_back({q.get(), pos, end});
+      queued += end - pos;
+    }
+  }
+  t.reserve(m_new.size() + queued);
+
+  auto later = [](const Run& a, const Run& b) {
+    return a.stamp() > b.stamp();
+  };
+  std::make_heap(runs.begin(), runs.end(), later);
+  auto spilled = m_new.begin();
+  while (!runs.empty()) {
+    if (spilled != m_new.end() &&
+	spilled->m_stamp < runs.front().stamp() &&
+	std::none_of(runs.begin(), runs.end(), [&](const Run& r) {
+	  return pthread_equal(r.q->owner, spilled->m_thread);
+	})) {
+      t.emplace_back(std::move(*spilled++));
+      continue;
+    }
+    std::pop_heap(runs.begin(), runs.end(), later);
+    auto& r = runs.back();
+    auto& slot = r.q->slots[r.pos % r.q->slots.size()];
+    t.emplace_back(std::move(*slot));
+    slot.reset();
+    if (++r.pos == r.end) {
+      r.q->head.store(r.pos, std::memory_order_release);
+      runs.pop_back();
+    } else {
+      std::push_heap(runs.begin(), runs.end(), later);
+    }
+  }
+  t.insert(t.end(), std::make_move_iterator(spilled),
+	   std::make_move_iterator(m_new.end()));
+  m_new.clear();
+  m_queued.fetch_sub(queued, std::memory_order_relaxed);
+
+  for (auto& q : m_thread_queues) {
+    q->spilled = false;
+  }
+  // forget the queues of threads that have exited
+  std::erase_if(m_thread_queues, [](auto& q) {
+    return q.use_count() == 1 && q->head == q->tail;
+  });
+  m_cond_loggers.notify_all();
+}
+
 void Log::flush()
 {
   std::scoped_lock lock1(m_flush_mutex);
@@ -275,9 +430,7 @@ void Log::flush()
   {
     std::scoped_lock lock2(m_queue_mutex);
     m_queue_mutex_holder = pthread_self();
-    assert(m_flush.empty());
-    m_flush.swap(m_new);
-    m_cond_loggers.notify_all();
+    _take_new(m_flush);
     m_queue_mutex_holder = 0;
   }
 
@@ -482,11 +635,12 @@ void Log::dump_recent()
   std::scoped_lock lock1(m_flush_mutex);
   m_flush_mutex_holder = pthread_self();
 
+  uint64_t spilled;
   {
     std::scoped_lock lock2(m_queue_mutex);
     m_queue_mutex_holder = pthread_self();
-    assert(m_flush.empty());
-    m_flush.swap(m_new);
+    _take_new(m_flush);
+    spilled = m_spilled;
     m_queue_mutex_holder = 0;
   }
 
@@ -526,7 +680,8 @@ void Log::dump_recent()
   }
 
   _log_message(fmt::format("  max_recent {:9}", m_recent.capacity()), true);
-  _log_message(fmt::format("  max_new    {:9}", m_max_new), true);
+  _log_message(fmt::format("  max_new    {:9}", m_max_new.load()), true);
+  _log_message(fmt::format("  spilled    {:9}", spilled), true);
   _log_message(fmt::format("  log_file {}", m_log_file), true);
 
   _log_message("--- end dump of recent events ---", true);
@@ -566,17 +721,22 @@ void *Log::entry()
     std::unique_lock lock(m_queue_mutex);
     m_queue_mutex_holder = pthread_self();
     while (!m_stop) {
-      if (!m_new.empty()) {
-        m_queue_mutex_holder = 0;
-        lock.unlock();
-        flush();
-        lock.lock();
-        m_queue_mutex_holder = pthread_self();
+      // submitters only take m_queue_mutex to wake us up if they see
+      // this set after filling their thread queue, and we look at the
+      // queues only after setting it, so one of us notices the other
+      m_flusher_waiting = true;
+      if (!_have_new()) {
+        m_cond_flusher.wait(lock);
         continue;
       }
-
-      m_cond_flusher.wait(lock);
+      m_flusher_waiting = false;
+      m_queue_mutex_holder = 0;
+      lock.unlock();
+      flush();
+      lock.lock();
+      m_queue_mutex_holder = pthread_self();
     }
+    m_flusher_waiting = false;
     m_queue_mutex_holder = 0;
   }
   flush();
@@ -6,12 +6,14 @@
 
 #include <boost/circular_buffer.hpp>
 
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "common/Thread.h"
 #include "common/likely.h"
@@ -89,6 +91,36 @@ private:
 
   static const std::size_t DEFAULT_MAX_NEW = 100;
   static const std::size_t DEFAULT_MAX_RECENT = 10000;
+  static const std::size_t THREAD_QUEUE_SIZE = 32;
+
+  /**
+   * Single producer, single consumer ring of new entries of one thread.
+   *
+   * The owning thread fills it without taking m_queue_mutex; the
+   * flusher drains it with m_queue_mutex held.  When it is full, or the
+   * thread queues of the Log hold m_max_new entries already, the owner
+   * falls back to m_new (and its backpressure) until the next flush, so
+   * that entries of a thread never overtake each other.  Entries are
+   * only allocated while queued, an idle ring is just its pointers.
+   */
+  struct ThreadQueue {
+    explicit ThreadQueue(std::size_t n)
+      : slots(n), owner(pthread_self()) {}
+    std::vector<std::unique_ptr<ConcreteEntry>> slots;
+    const pthread_t owner;
+    std::atomic<std::size_t> head = 0;   ///< next slot to drain
+    std::atomic<std::size_t> tail = 0;   ///< next slot to fill
+    std::atomic<bool> spilled = false;   ///< owner is using m_new
+    std::atomic<bool> detached = false;  ///< the Log is gone
+
+    ConcreteEntry& at(std::size_t i) {
+      return *slots[i % slots.size()];
+    }
+    bool try_push(const Entry& e);
+  };
+
+  static std::atomic<uint64_t> next_id;
+  const uint64_t m_id;
 
   Log **m_indirect_this;
 
@@ -102,6 +134,11 @@ private:
   pthread_t m_queue_mutex_holder;
   pthread_t m_flush_mutex_holder;
 
+  std::vector<std::shared_ptr<ThreadQueue>> m_thread_queues; ///< under m_queue_mutex
+  std::atomic<bool> m_flusher_waiting = false; ///< log thread is waiting for entries
+  std::atomic<std::size_t> m_queued = 0; ///< entries in all thread queues
+  uint64_t m_spilled = 0; ///< entries that overflowed a thread queue into m_new
+
   EntryVector m_new;    ///< new entries
   EntryRing m_recent; ///< recent (less new) entries we've already written at low detail
   EntryVector m_flush; ///< entries to be flushed (here to optimize heap allocations)
@@ -130,12 +167,16 @@ private:
 
   bool m_stop = false;
 
-  std::size_t m_max_new = DEFAULT_MAX_NEW;
+  std::atomic<std::size_t> m_max_new = DEFAULT_MAX_NEW;
 
   bool m_inject_segv = false;
 
   void *entry() override;
 
+  ThreadQueue* _get_thread_queue();
+  bool _have_new();
+  void _take_new(EntryVector& t);
+
   void _log_safe_write(std::string_view sv);
   void _flush_logbuf();
   void _log_message(std::string_view s, bool crash);
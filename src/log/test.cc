@@ -14,6 +14,10 @@
 
 #include <limits.h>
 
+#include <map>
+#include <sstream>
+#include <thread>
+
 using namespace std;
 using namespace ceph::logging;
 
@@ -170,6 +174,109 @@ TEST(Log, ManyGather)
   log.stop();
 }
 
+class CountingLog : public Log {
+public:
+  using Log::Log;
+  std::map<std::string, std::vector<int>> seen;
+protected:
+  void _flush(EntryVector& q, bool crash) override {
+    for (auto& e : q) {
+      std::istringstream is{std::string(e.strv())};
+      std::string who;
+      int i;
+      is >> who >> i;
+      seen[who].push_back(i);
+    }
+    Log::_flush(q, crash);
+  }
+};
+
+TEST(Log, ManyThreadsInOrder)
+{
+  SubsystemMap subs;
+  subs.set_log_level(1, 20);
+  subs.set_gather_level(1, 10);
+  CountingLog log(&subs);
+  log.set_max_new(10);
+  log.start();
+  constexpr int nthreads = 8;
+  constexpr int nlines = 5000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nthreads; t++) {
+    threads.emplace_back([&log, t] {
+      for (int i = 0; i < nlines; i++) {
+        MutableEntry e(10, 1);
+        e.get_ostream() << "t" << t << " " << i;
+        log.submit_entry(std::move(e));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  log.flush();
+  log.stop();
+  ASSERT_EQ(nthreads, (int)log.seen.size());
+  for (auto& [who, lines] : log.seen) {
+    ASSERT_EQ(nlines, (int)lines.size()) << who;
+    for (int i = 0; i < nlines; i++) {
+      ASSERT_EQ(i, lines[i]) << who;
+    }
+  }
+}
+
+TEST(Log, SpilledInOrderWhenClockStepsBack)
+{
+  SubsystemMap subs;
+  subs.set_log_level(1, 20);
+  subs.set_gather_level(1, 10);
+  CountingLog log(&subs);
+  // not started: nothing is flushed until we ask, so the thread queue
+  // fills up and the rest spills into m_new
+  constexpr int nlines = 100;
+  uint64_t now = Entry::clock().now().time_since_epoch().count().count;
+  for (int i = 0; i < nlines; i++) {
+    MutableEntry e(10, 1);
+    e.get_ostream() << "t " << i;
+    // the wall clock keeps stepping back
+    e.m_stamp = Entry::time(log_clock::duration(
+      log_clock::rep(now - i * 1000000000ull, false)));
+    log.submit_entry(std::move(e));
+  }
+  log.flush();
+  ASSERT_EQ(1u, log.seen.size());
+  auto& lines = log.seen["t"];
+  ASSERT_EQ(nlines, (int)lines.size());
+  for (int i = 0; i < nlines; i++) {
+    ASSERT_EQ(i, lines[i]);
+  }
+}
+
+TEST(Log, ThreadQueuesBoundedByMaxNew)
+{
+  SubsystemMap subs;
+  subs.set_log_level(1, 20);
+  subs.set_gather_level(1, 10);
+  CountingLog log(&subs);
+  // fewer than a thread queue holds: the rest goes to m_new, and the
+  // budget is given back once the queues are flushed
+  log.set_max_new(4);
+  constexpr int nlines = 10;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < nlines; i++) {
+      MutableEntry e(10, 1);
+      e.get_ostream() << "t " << round * nlines + i;
+      log.submit_entry(std::move(e));
+    }
+    log.flush();
+  }
+  auto& lines = log.seen["t"];
+  ASSERT_EQ(3 * nlines, (int)lines.size());
+  for (int i = 0; i < 3 * nlines; i++) {
+    ASSERT_EQ(i, lines[i]);
+  }
+}
+
 static void readpipe(int fd, int verify)
 {
   while (1) {
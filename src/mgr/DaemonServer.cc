@@ -334,6 +334,16 @@ bool DaemonServer::ms_handle_refused(Connection *con)
   return false;
 }
 
+bool DaemonServer::ms_can_sharded_dispatch(const MessageConstRef& m) const
+{
+  // pg stats from every osd are the bulk of what we receive.  Ingesting
+  // them only takes ClusterState's lock (and ours in maybe_ready()), and
+  // does not depend on ordering against the other message types of the
+  // connection, so they may be handled concurrently with each other and
+  // with the rest.
+  return m->get_type() == MSG_PGSTATS;
+}
+
 bool DaemonServer::ms_dispatch2(const ref_t<Message>& m)
 {
   // Note that we do *not* take ::lock here, in order to avoid
@@ -271,6 +271,7 @@ public:
 	       LogChannelRef auditcl);
   ~DaemonServer() override;
 
+  bool ms_can_sharded_dispatch(const MessageConstRef& m) const override;
   bool ms_dispatch2(const ceph::ref_t<Message>& m) override;
   int ms_handle_fast_authentication(Connection *con) override;
   void ms_handle_accept(Connection *con) override;
@@ -53,7 +53,7 @@ void MgrOpRequest::_dump(Formatter *f) const
 
     for (auto i = events.begin(); i != events.end(); ++i) {
       f->open_object_section("event");
-      f->dump_string("event", i->str);
+      f->dump_string("event", i->name());
       f->dump_stream("time") << i->stamp;
 
       double duration = 0;
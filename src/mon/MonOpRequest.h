@@ -107,7 +107,7 @@ private:
       std::lock_guard l(lock);
     for (auto i = events.begin(); i != events.end(); ++i) {
       f->open_object_section("event");
-      f->dump_string("event", i->str);
+      f->dump_string("event", i->name());
       f->dump_stream("time") << i->stamp;
 
       auto i_next = i + 1;
@@ -6311,7 +6311,7 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
 	    break;
 	  case HIT_SET_FPP:
 	    {
-	      if (p->hit_set_params.get_type() == HitSet::TYPE_BLOOM) {
+	      if (HitSet::is_bloom_type(p->hit_set_params.get_type())) {
 		BloomHitSet::Params *bloomp =
 		  static_cast<BloomHitSet::Params*>(p->hit_set_params.impl.get());
 		f->dump_float("hit_set_fpp", bloomp->get_fpp());
@@ -6459,7 +6459,7 @@ bool OSDMonitor::preprocess_command(MonOpRequestRef op)
 	    break;
 	  case HIT_SET_FPP:
 	    {
-	      if (p->hit_set_params.get_type() == HitSet::TYPE_BLOOM) {
+	      if (HitSet::is_bloom_type(p->hit_set_params.get_type())) {
 		BloomHitSet::Params *bloomp =
 		  static_cast<BloomHitSet::Params*>(p->hit_set_params.impl.get());
 		ss << "hit_set_fpp: " << bloomp->get_fpp() << "\n";
@@ -7570,6 +7570,28 @@ int OSDMonitor::check_cluster_features(uint64_t features,
   return 0;
 }
 
+/*
+ * blocked bloom hit set params are encoded in pg_pool_t, and anyone
+ * decoding the osdmap (clients included) fails on a type they do not
+ * know, so it takes a feature bit everywhere, not just a recent
+ * require_osd_release.
+ */
+int OSDMonitor::check_blocked_bloom_hit_set(stringstream &ss)
+{
+  if (osdmap.require_osd_release < ceph_release_t::squid) {
+    ss << "hit set type blocked_bloom requires require_osd_release >= squid";
+    return -EPERM;
+  }
+  if (osdmap.require_min_compat_client < ceph_release_t::squid) {
+    ss << "min_compat_client " << osdmap.require_min_compat_client
+       << " < squid, which is required for hit set type blocked_bloom. "
+       << "Try 'ceph osd set-require-min-compat-client squid' "
+       << "before using the new interface";
+    return -EPERM;
+  }
+  return check_cluster_features(CEPH_FEATUREMASK_OSD_HITSET_BLOCKED_BLOOM, ss);
+}
+
 bool OSDMonitor::validate_crush_against_features(const CrushWrapper *newcrush,
                                                  stringstream& ss)
 {
@@ -8670,6 +8692,13 @@ int OSDMonitor::prepare_command_pool_set(const cmdmap_t& cmdmap,
 	BloomHitSet::Params *bsp = new BloomHitSet::Params;
 	bsp->set_fpp(g_conf().get_val<double>("osd_pool_default_hit_set_bloom_fpp"));
 	p.hit_set_params = HitSet::Params(bsp);
+      } else if (val == "blocked_bloom") {
+	err = check_blocked_bloom_hit_set(ss);
+	if (err)
+	  return err;
+	BlockedBloomHitSet::Params *bsp = new BlockedBloomHitSet::Params;
+	bsp->set_fpp(g_conf().get_val<double>("osd_pool_default_hit_set_bloom_fpp"));
+	p.hit_set_params = HitSet::Params(bsp);
       } else if (val == "explicit_hash")
 	p.hit_set_params = HitSet::Params(new ExplicitHashHitSet::Params);
       else if (val == "explicit_object")
@@ -8705,7 +8734,7 @@ int OSDMonitor::prepare_command_pool_set(const cmdmap_t& cmdmap,
       ss << "hit_set_fpp should be in the range 0..1";
       return -EINVAL;
     }
-    if (p.hit_set_params.get_type() != HitSet::TYPE_BLOOM) {
+    if (!HitSet::is_bloom_type(p.hit_set_params.get_type())) {
       ss << "hit set is not of type Bloom; invalid to set a false positive rate!";
       return -EINVAL;
     }
@@ -13801,6 +13830,15 @@ bool OSDMonitor::prepare_command_impl(MonOpRequestRef op,
       BloomHitSet::Params *bsp = new BloomHitSet::Params;
       bsp->set_fpp(g_conf().get_val<double>("osd_pool_default_hit_set_bloom_fpp"));
       hsp = HitSet::Params(bsp);
+    } else if (cache_hit_set_type == "blocked_bloom") {
+      err = check_blocked_bloom_hit_set(ss);
+      if (err == -EAGAIN)
+	goto wait;
+      if (err < 0)
+	goto reply_no_propose;
+      BlockedBloomHitSet::Params *bsp = new BlockedBloomHitSet::Params;
+      bsp->set_fpp(g_conf().get_val<double>("osd_pool_default_hit_set_bloom_fpp"));
+      hsp = HitSet::Params(bsp);
     } else if (cache_hit_set_type == "explicit_hash") {
       hsp = HitSet::Params(new ExplicitHashHitSet::Params);
     } else if (cache_hit_set_type == "explicit_object") {
@@ -421,6 +421,7 @@ public:
    * @param ss Filled in with ane explanation of failure, if any
    */
   int check_cluster_features(uint64_t features, std::stringstream &ss);
+  int check_blocked_bloom_hit_set(std::stringstream &ss);
   // @param req an optional op request, if the osdmaps are replies to it. so
   //            @c Monitor::send_reply() can mark_event with it.
   void send_incremental(epoch_t first, MonSession *session, bool onetime,
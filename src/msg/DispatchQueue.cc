@@ -12,6 +12,8 @@
  * 
  */
 
+#include <fmt/format.h>
+
 #include "msg/Message.h"
 #include "DispatchQueue.h"
 #include "Messenger.h"
@@ -80,8 +82,30 @@ void DispatchQueue::fast_preprocess(const ref_t<Message>& m)
   msgr->ms_fast_preprocess(m);
 }
 
+bool DispatchQueue::enqueue_sharded(const ref_t<Message>& m, uint64_t id)
+{
+  Dispatcher *dispatcher = msgr->ms_get_sharded_dispatcher(m);
+  if (!dispatcher) {
+    return false;
+  }
+  auto& shard = *shards[id % shards.size()];
+  std::lock_guard l{shard.lock};
+  if (shard.stop) {
+    return true;
+  }
+  ldout(cct,20) << "queue " << m << " on shard " << id % shards.size() << dendl;
+  shard.q.push_back({id, dispatcher, m});
+  if (shard.q.size() == 1) {
+    shard.cond.notify_all();
+  }
+  return true;
+}
+
 void DispatchQueue::enqueue(const ref_t<Message>& m, int priority, uint64_t id)
 {
+  if (!shards.empty() && enqueue_sharded(m, id)) {
+    return;
+  }
   std::lock_guard l{lock};
   if (stop) {
     return;
@@ -213,7 +237,51 @@ void DispatchQueue::entry()
   }
 }
 
+/*
+ * Sharded messages are delivered in arrival order: they all come from
+ * connections hashed to this shard, and a connection only ever maps to
+ * one shard, so per connection ordering is kept without mqueue.
+ */
+void DispatchQueue::shard_entry(DispatchShard *shard)
+{
+  std::unique_lock l{shard->lock};
+  while (true) {
+    while (!shard->q.empty()) {
+      auto item = std::move(shard->q.front());
+      shard->q.pop_front();
+      const ref_t<Message>& m = item.m;
+      if (shard->stop) {
+	ldout(cct,10) << " stop flag set, discarding " << m << " " << *m << dendl;
+	continue;
+      }
+      l.unlock();
+
+      uint64_t msize = pre_dispatch(m);
+      msgr->ms_deliver_sharded_dispatch(item.dispatcher, m);
+      post_dispatch(m, msize);
+
+      l.lock();
+    }
+    if (shard->stop)
+      break;
+
+    shard->cond.wait(l);
+  }
+}
+
 void DispatchQueue::discard_queue(uint64_t id) {
+  if (!shards.empty()) {
+    auto& shard = *shards[id % shards.size()];
+    std::lock_guard l{shard.lock};
+    for (auto i = shard.q.begin(); i != shard.q.end(); ) {
+      if (i->id == id) {
+	dispatch_throttle_release(i->m->get_dispatch_throttle_size());
+	i = shard.q.erase(i);
+      } else {
+	++i;
+      }
+    }
+  }
   std::lock_guard l{lock};
   std::list<QueueItem> removed;
   mqueue.remove_by_class(id, &removed);
@@ -230,6 +298,9 @@ void DispatchQueue::start()
   ceph_assert(!stop);
   ceph_assert(!dispatch_thread.is_started());
   dispatch_thread.create("ms_dispatch");
+  for (size_t i = 0; i < shards.size(); ++i) {
+    shards[i]->thread.create(fmt::format("ms_dispatch_{}", i).c_str());
+  }
   local_delivery_thread.create("ms_local");
 }
 
@@ -237,6 +308,9 @@ void DispatchQueue::wait()
 {
   local_delivery_thread.join();
   dispatch_thread.join();
+  for (auto& shard : shards) {
+    shard->thread.join();
+  }
 }
 
 void DispatchQueue::discard_local()
@@ -258,4 +332,9 @@ void DispatchQueue::shutdown()
     stop = true;
     cond.notify_all();
   }
+  for (auto& shard : shards) {
+    std::scoped_lock l{shard->lock};
+    shard->stop = true;
+    shard->cond.notify_all();
+  }
 }
@@ -16,8 +16,11 @@
 #define CEPH_DISPATCHQUEUE_H
 
 #include <atomic>
+#include <deque>
 #include <map>
+#include <memory>
 #include <queue>
+#include <vector>
 #include <boost/intrusive_ptr.hpp>
 #include "include/ceph_assert.h"
 #include "include/common_fwd.h"
@@ -28,6 +31,7 @@
 
 #include "Message.h"
 
+class Dispatcher;
 class Messenger;
 struct Connection;
 
@@ -103,6 +107,42 @@ class DispatchQueue {
     }
   } dispatch_thread;
 
+  /**
+   * Messages a Dispatcher has opted in to sharded dispatch for skip
+   * mqueue and the dispatch thread.  They are spread over
+   * ms_dispatch_shards threads by connection id, so delivery stays in
+   * order per connection while different connections proceed in
+   * parallel.
+   */
+  struct DispatchShard {
+    ceph::mutex lock;
+    ceph::condition_variable cond;
+    struct Item {
+      uint64_t id;              ///< connection id
+      Dispatcher *dispatcher;   ///< the one that opted in
+      ceph::ref_t<Message> m;
+    };
+    std::deque<Item> q;
+    bool stop = false;
+    class ShardThread : public Thread {
+      DispatchQueue *dq;
+      DispatchShard *shard;
+    public:
+      ShardThread(DispatchQueue *dq, DispatchShard *shard)
+	: dq(dq), shard(shard) {}
+      void *entry() override {
+	dq->shard_entry(shard);
+	return 0;
+      }
+    } thread;
+    DispatchShard(DispatchQueue *dq, const std::string& name)
+      : lock(ceph::make_mutex("Messenger::DispatchQueue::shard_lock" + name)),
+	thread(dq, this) {}
+  };
+  std::vector<std::unique_ptr<DispatchShard>> shards;
+  bool enqueue_sharded(const ceph::ref_t<Message>& m, uint64_t id);
+  void shard_entry(DispatchShard *shard);
+
   ceph::mutex local_delivery_lock;
   ceph::condition_variable local_delivery_cond;
   bool stop_local_delivery;
@@ -135,8 +175,13 @@ class DispatchQueue {
   double get_max_age(utime_t now) const;
 
   int get_queue_len() const {
+    int len = 0;
+    for (auto& shard : shards) {
+      std::lock_guard l{shard->lock};
+      len += shard->q.size();
+    }
     std::lock_guard l{lock};
-    return mqueue.length();
+    return len + mqueue.length();
   }
 
   /**
@@ -231,8 +276,15 @@ class DispatchQueue {
       dispatch_throttler(cct, std::string("msgr_dispatch_throttler-") + name,
                          cct->_conf->ms_dispatch_throttle_bytes),
       stop(false)
-    {}
+    {
+      for (unsigned i = 0; i < cct->_conf->ms_dispatch_shards; ++i) {
+	shards.emplace_back(std::make_unique<DispatchShard>(this, name));
+      }
+    }
   ~DispatchQueue() {
+    for (auto& shard : shards) {
+      ceph_assert(shard->q.empty());
+    }
     ceph_assert(mqueue.empty());
     ceph_assert(marrival.empty());
     ceph_assert(local_messages.empty());
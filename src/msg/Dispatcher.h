@@ -113,6 +113,26 @@ public:
     return ms_fast_preprocess(m.get());
   }
 
+  /**
+   * Opt a message type in to sharded dispatch.  With ms_dispatch_shards
+   * set, such messages bypass the single dispatch thread and are handed
+   * to this Dispatcher's ms_dispatch2, and no other Dispatcher's, from
+   * one of several shard threads chosen by Connection, so
+   * 1) ms_dispatch2 may run concurrently for messages from different
+   * Connections;
+   * 2) ordering is kept among the sharded messages of a Connection, but
+   * not against its messages that go through the regular dispatch
+   * thread.
+   * Only opt in types that do not depend on either.  The first
+   * Dispatcher (in dispatch order) that opts in gets the message.
+   *
+   * @param m The message we want to dispatch.
+   * @returns True if the message can be dispatched from a shard thread.
+   */
+  virtual bool ms_can_sharded_dispatch(const MessageConstRef& m) const {
+    return false;
+  }
+
   /**
    * The Messenger calls this function to deliver a single message.
    *
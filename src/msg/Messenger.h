@@ -718,6 +718,39 @@ public:
       dispatcher->ms_fast_preprocess2(m);
     }
   }
+  /**
+   * Find the Dispatcher that opted in to sharded dispatch of a Message;
+   * see Dispatcher::ms_can_sharded_dispatch().  As with fast dispatch,
+   * the Message is then delivered to that Dispatcher only.
+   *
+   * @param m The Message we are testing.
+   * @returns The Dispatcher, or nullptr if none opted in.
+   */
+  Dispatcher *ms_get_sharded_dispatcher(const ceph::cref_t<Message>& m) {
+    for ([[maybe_unused]] const auto& [priority, dispatcher] : dispatchers) {
+      if (dispatcher->ms_can_sharded_dispatch(m)) {
+        return dispatcher;
+      }
+    }
+    return nullptr;
+  }
+  /**
+   * Deliver a single Message from a dispatch shard to the Dispatcher
+   * returned by ms_get_sharded_dispatcher() for it.
+   *
+   * @param dispatcher The Dispatcher that opted in.
+   * @param m The Message to deliver.
+   */
+  void ms_deliver_sharded_dispatch(Dispatcher *dispatcher,
+				   const ceph::ref_t<Message> &m) {
+    m->set_dispatch_stamp(ceph_clock_now());
+    if (!dispatcher->ms_dispatch2(m)) {
+      lsubdout(cct, ms, 0) << "ms_deliver_sharded_dispatch: unhandled message "
+			   << m << " " << *m << " from "
+			   << m->get_source_inst() << dendl;
+      ceph_assert(!cct->_conf->ms_die_on_unhandled_msg);
+    }
+  }
   /**
    *  Deliver a single Message. Send it to each Dispatcher
    *  in sequence until one of them handles it.
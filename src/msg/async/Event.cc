@@ -389,7 +389,69 @@ int EventCenter::process_time_events()
   return processed;
 }
 
-int EventCenter::process_events(unsigned timeout_microseconds,  ceph::timespan *working_dur)
+/*
+ * Spin on the driver for up to ms_async_busy_poll_us before the caller
+ * parks in a blocking wait, so that a reply arriving shortly after we
+ * ran out of work is picked up without a sleep/wakeup round trip.  The
+ * budget is cut back while spins keep coming up empty and restored as
+ * soon as one pays off, so an idle worker mostly sleeps.
+ *
+ * Returns true if the spin found work; *numevents then holds the
+ * driver result, and the caller must not wait again.
+ */
+bool EventCenter::busy_poll(std::vector<FiredFileEvent> &fired_events,
+                            int *numevents, unsigned timeout_microseconds,
+                            busy_poll_stats_t *poll_stats)
+{
+  const ceph::timespan max_budget =
+    std::chrono::microseconds(cct->_conf->ms_async_busy_poll_us);
+  if (max_budget == ceph::timespan::zero()) {
+    return false;
+  }
+  if (busy_poll_budget == ceph::timespan::zero() ||
+      busy_poll_budget > max_budget) {
+    busy_poll_budget = max_budget;
+  }
+
+  struct timeval zero = {0, 0};
+  bool found = false;
+  auto start = ceph::mono_clock::now();
+  auto deadline = start + std::min<ceph::timespan>(
+    busy_poll_budget, std::chrono::microseconds(timeout_microseconds));
+  auto now = start;
+  do {
+    if (external_num_events.load()) {
+      *numevents = 0;
+      found = true;
+      break;
+    }
+    *numevents = driver->event_wait(fired_events, &zero);
+    now = ceph::mono_clock::now();
+    if (*numevents != 0) {
+      found = true;
+      break;
+    }
+  } while (now < deadline);
+
+  if (found) {
+    busy_poll_budget = max_budget;
+  } else {
+    busy_poll_budget = std::max(busy_poll_budget / 2, max_budget / 8);
+  }
+  if (poll_stats) {
+    poll_stats->spin_time += now - start;
+    if (found) {
+      poll_stats->hits++;
+    } else {
+      poll_stats->misses++;
+    }
+  }
+  return found;
+}
+
+int EventCenter::process_events(unsigned timeout_microseconds,
+                                ceph::timespan *working_dur,
+                                busy_poll_stats_t *poll_stats)
 {
   struct timeval tv;
   int numevents;
@@ -419,7 +481,22 @@ int EventCenter::process_events(unsigned timeout_microseconds,  ceph::timespan *
 
   ldout(cct, 30) << __func__ << " wait second " << tv.tv_sec << " usec " << tv.tv_usec << dendl;
   std::vector<FiredFileEvent> fired_events;
-  numevents = driver->event_wait(fired_events, &tv);
+  if (!blocking || timeout_microseconds == 0) {
+    numevents = driver->event_wait(fired_events, &tv);
+  } else {
+    auto spin_start = ceph::mono_clock::now();
+    if (!busy_poll(fired_events, &numevents, timeout_microseconds, poll_stats)) {
+      // the spin already used up part of the timeout; only wait for the rest
+      auto spun = std::chrono::duration_cast<std::chrono::microseconds>(
+        ceph::mono_clock::now() - spin_start).count();
+      if (spun > 0) {
+        timeout_microseconds -= std::min<uint64_t>(spun, timeout_microseconds);
+        tv.tv_sec = timeout_microseconds / 1000000;
+        tv.tv_usec = timeout_microseconds % 1000000;
+      }
+      numevents = driver->event_wait(fired_events, &tv);
+    }
+  }
   auto working_start = ceph::mono_clock::now();
   for (int event_id = 0; event_id < numevents; event_id++) {
     int rfired = 0;
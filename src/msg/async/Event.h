@@ -155,6 +155,13 @@ class EventCenter {
     int slot;
   };
 
+  /// what the busy poll phase of process_events() cost and found
+  struct busy_poll_stats_t {
+    ceph::timespan spin_time = ceph::timespan::zero();
+    uint64_t hits = 0;   ///< spins that found work before parking
+    uint64_t misses = 0; ///< spins that ran out of budget and parked
+  };
+
  private:
   CephContext *cct;
   std::string type;
@@ -180,7 +187,14 @@ class EventCenter {
   unsigned center_id;
   AssociatedCenters *global_centers = nullptr;
 
+  // current spin budget of busy_poll(), adapted between
+  // ms_async_busy_poll_us / 8 and ms_async_busy_poll_us
+  ceph::timespan busy_poll_budget = ceph::timespan::zero();
+
   int process_time_events();
+  bool busy_poll(std::vector<FiredFileEvent> &fired_events, int *numevents,
+                 unsigned timeout_microseconds,
+                 busy_poll_stats_t *poll_stats);
   FileEvent *_get_file_event(int fd) {
     ceph_assert(fd < nevent);
     return &file_events[fd];
@@ -208,7 +222,9 @@ class EventCenter {
   uint64_t create_time_event(uint64_t microseconds, EventCallbackRef ctxt);
   void delete_file_event(int fd, int mask);
   void delete_time_event(uint64_t id);
-  int process_events(unsigned timeout_microseconds, ceph::timespan *working_dur = nullptr);
+  int process_events(unsigned timeout_microseconds,
+                     ceph::timespan *working_dur = nullptr,
+                     busy_poll_stats_t *poll_stats = nullptr);
   void wakeup();
 
   // Used by external thread
@@ -559,19 +559,23 @@ ssize_t ProtocolV2::write_message(Message *m, bool more) {
                  << " src=" << entity_name_t(messenger->get_myname())
                  << " off=" << header2.data_off
                  << dendl;
-  ssize_t total_send_size = connection->outgoing_bl.length();
-  ssize_t rc = connection->_try_send(more);
-  if (rc < 0) {
-    ldout(cct, 1) << __func__ << " error sending " << m << ", "
-                  << cpp_strerror(rc) << dendl;
+  ssize_t rc = 0;
+  ssize_t pending = connection->outgoing_bl.length();
+  if (more && pending < write_batch_bytes()) {
+    // more messages are queued behind this one; let their frames join
+    // it in outgoing_bl so that they go out with a single sendmsg.
+    // write_event() flushes whatever is left once the queue drains.
+    ldout(cct, 20) << __func__ << " batching " << m << ", "
+		   << pending << " bytes pending" << dendl;
   } else {
-    const auto sent_bytes = total_send_size - connection->outgoing_bl.length();
-    connection->logger->inc(l_msgr_send_bytes, sent_bytes);
-    if (session_stream_handlers.tx) {
-      connection->logger->inc(l_msgr_send_encrypted_bytes, sent_bytes);
+    rc = try_send(more);
+    if (rc < 0) {
+      ldout(cct, 1) << __func__ << " error sending " << m << ", "
+		    << cpp_strerror(rc) << dendl;
+    } else {
+      ldout(cct, 10) << __func__ << " sending " << m
+		     << (rc ? " continuely." : " done.") << dendl;
     }
-    ldout(cct, 10) << __func__ << " sending " << m
-                   << (rc ? " continuely." : " done.") << dendl;
   }
 
 #if defined(WITH_EVENTTRACE)
@@ -585,6 +589,21 @@ ssize_t ProtocolV2::write_message(Message *m, bool more) {
   return rc;
 }
 
+ssize_t ProtocolV2::try_send(bool more) {
+  ssize_t pending = connection->outgoing_bl.length();
+  ssize_t rc = connection->_try_send(more);
+  if (rc >= 0) {
+    // outgoing_bl may hold several batched frames; account for all of
+    // them as they leave, whichever call gets them out
+    const auto sent_bytes = pending - connection->outgoing_bl.length();
+    connection->logger->inc(l_msgr_send_bytes, sent_bytes);
+    if (session_stream_handlers.tx) {
+      connection->logger->inc(l_msgr_send_encrypted_bytes, sent_bytes);
+    }
+  }
+  return rc;
+}
+
 template <class F>
 bool ProtocolV2::append_frame(F& frame) {
   ceph::bufferlist bl;
@@ -659,8 +678,10 @@ void ProtocolV2::write_event() {
     auto start = ceph::mono_clock::now();
     bool more;
     do {
-      if (connection->is_queued()) {
-	if (r = connection->_try_send(); r!= 0) {
+      if (connection->is_queued() &&
+	  (out_queue.empty() ||
+	   connection->outgoing_bl.length() >= write_batch_bytes())) {
+	if (r = try_send(); r!= 0) {
 	  // either fails to send or not all queued buffer is sent
 	  break;
 	}
@@ -716,12 +737,12 @@ void ProtocolV2::write_event() {
         if (append_frame(ack_frame)) {
           ack_left -= left;
           left = ack_left;
-          r = connection->_try_send(left);
+          r = try_send(left);
         } else {
           r = -EILSEQ;
         }
       } else if (is_queued()) {
-        r = connection->_try_send();
+        r = try_send();
       }
     }
     connection->write_lock.unlock();
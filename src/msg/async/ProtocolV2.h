@@ -151,6 +151,10 @@ private:
   void prepare_send_message(uint64_t features, Message *m);
   out_queue_entry_t _get_next_outgoing();
   ssize_t write_message(Message *m, bool more);
+  ssize_t try_send(bool more = false);
+  ssize_t write_batch_bytes() const {
+    return static_cast<ssize_t>(cct->_conf->ms_async_write_batch_bytes);
+  }
   void handle_message_ack(uint64_t seq);
   void reset_compression();
 
@@ -47,13 +47,19 @@ std::function<void ()> NetworkStack::add_thread(Worker* w)
         ldout(cct, 30) << __func__ << " calling event process" << dendl;
 
         ceph::timespan dur;
-        int r = w->center.process_events(EventMaxWaitUs, &dur);
+        EventCenter::busy_poll_stats_t poll_stats;
+        int r = w->center.process_events(EventMaxWaitUs, &dur, &poll_stats);
         if (r < 0) {
           ldout(cct, 20) << __func__ << " process events failed: "
                          << cpp_strerror(errno) << dendl;
           // TODO do something?
         }
         w->perf_logger->tinc(l_msgr_running_total_time, dur);
+        if (poll_stats.hits || poll_stats.misses) {
+          w->perf_logger->tinc(l_msgr_busy_poll_time, poll_stats.spin_time);
+          w->perf_logger->inc(l_msgr_busy_poll_hits, poll_stats.hits);
+          w->perf_logger->inc(l_msgr_busy_poll_misses, poll_stats.misses);
+        }
       }
       w->reset();
       w->destroy();
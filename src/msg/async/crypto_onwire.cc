@@ -18,6 +18,9 @@ static constexpr const std::size_t AESGCM_KEY_LEN{16};
 static constexpr const std::size_t AESGCM_IV_LEN{12};
 static constexpr const std::size_t AESGCM_TAG_LEN{16};
 static constexpr const std::size_t AESGCM_BLOCK_LEN{16};
+// plaintext buffers shorter than this are gathered in the output buffer
+// and encrypted in place together, see authenticated_encrypt_update()
+static constexpr const std::size_t AESGCM_GATHER_MAX{4096};
 
 struct nonce_t {
   ceph_le32 fixed;
@@ -39,11 +42,17 @@ class AES128GCM_OnWireTxHandler : public ceph::crypto::onwire::TxHandler {
   CephContext* const cct;
   std::unique_ptr<EVP_CIPHER_CTX, decltype(&::EVP_CIPHER_CTX_free)> ectx;
   ceph::bufferlist buffer;
+  // plaintext copied to buffer but not encrypted yet
+  char* gathered = nullptr;
+  unsigned gathered_len = 0;
   nonce_t nonce, initial_nonce;
   bool used_initial_nonce;
   bool new_nonce_format;  // 64-bit counter?
   static_assert(sizeof(nonce) == AESGCM_IV_LEN);
 
+  void encrypt(char* out, const char* in, unsigned len);
+  void encrypt_gathered();
+
 public:
   AES128GCM_OnWireTxHandler(CephContext* const cct,
 			    const key_t& key,
@@ -94,6 +103,7 @@ void AES128GCM_OnWireTxHandler::reset_tx_handler(const uint32_t* first,
   }
 
   ceph_assert(buffer.get_append_buffer_unused_tail_length() == 0);
+  ceph_assert(gathered_len == 0);
   buffer.reserve(std::accumulate(first, last, AESGCM_TAG_LEN));
 
   if (!new_nonce_format) {
@@ -105,6 +115,31 @@ void AES128GCM_OnWireTxHandler::reset_tx_handler(const uint32_t* first,
   }
 }
 
+void AES128GCM_OnWireTxHandler::encrypt(char* out, const char* in,
+					 unsigned len)
+{
+  int update_len = 0;
+
+  if(1 != EVP_EncryptUpdate(ectx.get(),
+	reinterpret_cast<unsigned char*>(out),
+	&update_len,
+	reinterpret_cast<const unsigned char*>(in),
+	len)) {
+    throw std::runtime_error("EVP_EncryptUpdate failed");
+  }
+  ceph_assert_always(update_len >= 0);
+  ceph_assert(static_cast<unsigned>(update_len) == len);
+}
+
+void AES128GCM_OnWireTxHandler::encrypt_gathered()
+{
+  if (gathered_len > 0) {
+    encrypt(gathered, gathered, gathered_len);
+    gathered = nullptr;
+    gathered_len = 0;
+  }
+}
+
 void AES128GCM_OnWireTxHandler::authenticated_encrypt_update(
   const ceph::bufferlist& plaintext)
 {
@@ -112,29 +147,41 @@ void AES128GCM_OnWireTxHandler::authenticated_encrypt_update(
               plaintext.length());
   auto filler = buffer.append_hole(plaintext.length());
 
+  // Every EVP_EncryptUpdate() has a fixed cost, and lengths that are not
+  // a multiple of the block size push GCM onto its bytewise path, which
+  // dominates for frames made of many small buffers (the preamble, the
+  // header and encoded front segments).  So small buffers are copied to
+  // their place in the output, which is contiguous for the whole frame,
+  // and encrypted there in place with a single call, possibly spanning
+  // several segments.  Large buffers are encrypted straight into place.
   for (const auto& plainbuf : plaintext.buffers()) {
-    int update_len = 0;
-
-    if(1 != EVP_EncryptUpdate(ectx.get(),
-	reinterpret_cast<unsigned char*>(filler.c_str()),
-	&update_len,
-	reinterpret_cast<const unsigned char*>(plainbuf.c_str()),
-	plainbuf.length())) {
-      throw std::runtime_error("EVP_EncryptUpdate failed");
+    if (plainbuf.length() < AESGCM_GATHER_MAX) {
+      if (gathered_len == 0) {
+	gathered = filler.c_str();
+      }
+      filler.copy_in(plainbuf.length(), plainbuf.c_str());
+      gathered_len += plainbuf.length();
+      if (gathered_len >= AESGCM_GATHER_MAX) {
+	encrypt_gathered();
+      }
+    } else {
+      encrypt_gathered();
+      encrypt(filler.c_str(), plainbuf.c_str(), plainbuf.length());
+      filler.advance(plainbuf.length());
     }
-    ceph_assert_always(update_len >= 0);
-    ceph_assert(static_cast<unsigned>(update_len) == plainbuf.length());
-    filler.advance(update_len);
   }
 
   ldout(cct, 15) << __func__
 		 << " plaintext.length()=" << plaintext.length()
 		 << " buffer.length()=" << buffer.length()
+		 << " gathered_len=" << gathered_len
 		 << dendl;
 }
 
 ceph::bufferlist AES128GCM_OnWireTxHandler::authenticated_encrypt_final()
 {
+  encrypt_gathered();
+
   int final_len = 0;
   ceph_assert(buffer.get_append_buffer_unused_tail_length() ==
               AESGCM_BLOCK_LEN);
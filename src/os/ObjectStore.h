@@ -491,6 +491,37 @@ public:
      ceph::buffer::list& bl,
      uint32_t op_flags = 0) = 0;
 
+  /**
+   * read_crc32c -- crc32c of a byte range of data of an object
+   *
+   * Same result as read() followed by *crc = bl.crc32c(*crc), without
+   * returning the data.  A store that keeps its own crc32c checksums
+   * may verify those against the device and compose the result from
+   * them instead of copying the data out and hashing it again.
+   *
+   * @param cid collection for object
+   * @param oid oid of object
+   * @param offset location offset of first byte to be read
+   * @param len number of bytes to be read
+   * @param crc [in] seed, [out] crc32c of the range read
+   * @param op_flags is CEPH_OSD_OP_FLAG_*
+   * @returns number of bytes read on success, or negative error code on failure.
+   */
+   virtual int read_crc32c(
+     CollectionHandle &c,
+     const ghobject_t& oid,
+     uint64_t offset,
+     size_t len,
+     uint32_t *crc,
+     uint32_t op_flags = 0) {
+     ceph::buffer::list bl;
+     int r = read(c, oid, offset, len, bl, op_flags);
+     if (r > 0) {
+       *crc = bl.crc32c(*crc);
+     }
+     return r;
+   }
+
   /**
    * fiemap -- get extent std::map of data of an object
    *
@@ -512,6 +543,26 @@ public:
    virtual int fiemap(CollectionHandle& c, const ghobject_t& oid,
 		      uint64_t offset, size_t len, std::map<uint64_t, uint64_t>& destmap) = 0;
 
+  /**
+   * get_device_offsets -- where on the device each object's data starts
+   *
+   * Callers that read a batch of objects in full (deep scrub) can visit
+   * them in device order so that the device sees mostly ascending reads
+   * instead of the hash order in which the objects are listed.
+   *
+   * @param cid collection for objects
+   * @param oids objects to look up
+   * @param offsets [out] one entry per oid: device offset of the first
+   *        data extent, or UINT64_MAX if it has none or it is not known
+   * @returns 0 on success, -EOPNOTSUPP if the store has no such notion
+   */
+   virtual int get_device_offsets(
+     CollectionHandle &c,
+     const std::vector<ghobject_t>& oids,
+     std::vector<uint64_t> *offsets) {
+     return -EOPNOTSUPP;
+   }
+
   /**
    * readv -- read specfic intervals from an object;
    * caller must call fiemap to fill in the extent-map first.
@@ -11820,6 +11820,60 @@ int BlueStore::read(
   return r;
 }
 
+int BlueStore::read_crc32c(
+  CollectionHandle &c_,
+  const ghobject_t& oid,
+  uint64_t offset,
+  size_t length,
+  uint32_t *crc,
+  uint32_t op_flags)
+{
+  if (!cct->_conf.get_val<bool>("bluestore_read_crc32c_reuse_csum")) {
+    return ObjectStore::read_crc32c(c_, oid, offset, length, crc, op_flags);
+  }
+  auto start = mono_clock::now();
+  Collection *c = static_cast<Collection *>(c_.get());
+  const coll_t &cid = c->get_cid();
+  dout(15) << __func__ << " " << cid << " " << oid
+	   << " 0x" << std::hex << offset << "~" << length << std::dec
+	   << dendl;
+  if (!c->exists)
+    return -ENOENT;
+
+  int r;
+  {
+    std::shared_lock l(c->lock);
+    OnodeRef o = c->get_onode(oid, false);
+    if (!o || !o->exists) {
+      r = -ENOENT;
+      goto out;
+    }
+
+    if (offset == length && offset == 0)
+      length = o->onode.size;
+
+    r = _do_read_crc32c(c, o, offset, length, crc, op_flags);
+    if (r == -EIO) {
+      logger->inc(l_bluestore_read_eio);
+    }
+  }
+
+ out:
+  if (r >= 0 && _debug_data_eio(oid)) {
+    r = -EIO;
+    derr << __func__ << " " << c->cid << " " << oid << " INJECT EIO" << dendl;
+  }
+  dout(10) << __func__ << " " << cid << " " << oid
+	   << " 0x" << std::hex << offset << "~" << length
+	   << " crc 0x" << *crc << std::dec
+	   << " = " << r << dendl;
+  log_latency(__func__,
+    l_bluestore_read_lat,
+    mono_clock::now() - start,
+    cct->_conf->bluestore_log_op_age);
+  return r;
+}
+
 void BlueStore::_read_cache(
   OnodeRef& o,
   uint64_t offset,
@@ -12199,6 +12253,230 @@ int BlueStore::_do_read(
   return r;
 }
 
+int BlueStore::_generate_read_result_crc32c(
+  OnodeRef& o,
+  uint64_t offset,
+  size_t length,
+  ready_regions_t& ready_regions,
+  vector<bufferlist>& compressed_blob_bls,
+  blobs2read_t& blobs2read,
+  bool* csum_error,
+  uint32_t *crc)
+{
+  // the stored csums can stand in for the data only if we would have
+  // failed the read on a mismatch
+  bool reuse = !cct->_conf->bluestore_ignore_data_csum &&
+    cct->_conf->bluestore_debug_inject_csum_err_probability <= 0;
+  ready_crcs_t ready_crcs;
+  auto p = compressed_blob_bls.begin();
+  for (auto& [bptr, r2r] : blobs2read) {
+    const bluestore_blob_t& blob = bptr->get_blob();
+    dout(20) << __func__ << "  blob " << *bptr << " need "
+             << r2r << dendl;
+    if (blob.is_compressed()) {
+      ceph_assert(p != compressed_blob_bls.end());
+      bufferlist& compressed_bl = *p++;
+      if (_verify_csum(o, &blob, 0, compressed_bl,
+                       r2r.front().regs.front().logical_offset) < 0) {
+        *csum_error = true;
+        return -EIO;
+      }
+      bufferlist raw_bl;
+      auto r = _decompress(compressed_bl, &raw_bl);
+      if (r < 0)
+        return r;
+      for (auto& req : r2r) {
+        for (auto& r : req.regs) {
+          ready_regions[r.logical_offset].substr_of(
+            raw_bl, r.blob_xoffset, r.length);
+        }
+      }
+      continue;
+    }
+    if (!reuse || blob.csum_type != Checksummer::CSUM_CRC32C) {
+      for (auto& req : r2r) {
+        if (_verify_csum(o, &blob, req.r_off, req.bl,
+                         req.regs.front().logical_offset) < 0) {
+          *csum_error = true;
+          return -EIO;
+        }
+        for (const auto& r : req.regs) {
+          ready_regions[r.logical_offset].substr_of(req.bl, r.front, r.length);
+        }
+      }
+      continue;
+    }
+    // verify the csum chunks ourselves, keeping their crcs; req.bl is
+    // chunk aligned (see _read_cache)
+    const uint32_t chunk_size = blob.get_csum_chunk_size();
+    for (auto& req : r2r) {
+      ceph_assert(req.r_off % chunk_size == 0);
+      ceph_assert(req.bl.length() % chunk_size == 0);
+      std::vector<uint32_t> chunk_crcs(req.bl.length() / chunk_size);
+      auto it = req.bl.cbegin();
+      for (size_t i = 0; i < chunk_crcs.size(); ++i) {
+        chunk_crcs[i] = it.crc32c(chunk_size, -1);
+        if (chunk_crcs[i] != blob.get_csum_item(req.r_off / chunk_size + i)) {
+          // let _verify_csum find and log the bad chunk
+          _verify_csum(o, &blob, req.r_off, req.bl,
+                       req.regs.front().logical_offset);
+          *csum_error = true;
+          return -EIO;
+        }
+      }
+      for (const auto& r : req.regs) {
+        // whole chunks in the middle of the region come from
+        // chunk_crcs, partial ones at either end from the data
+        uint64_t front = r.front;
+        uint64_t end = r.front + r.length;
+        uint64_t first = p2roundup<uint64_t>(front, chunk_size);
+        uint64_t last = p2align<uint64_t>(end, chunk_size);
+        if (first >= last) {
+          ready_regions[r.logical_offset].substr_of(req.bl, front, r.length);
+          continue;
+        }
+        if (front < first) {
+          ready_regions[r.logical_offset].substr_of(req.bl, front,
+                                                    first - front);
+        }
+        for (uint64_t x = first; x < last; x += chunk_size) {
+          ready_crcs[r.logical_offset + x - front] =
+            {chunk_crcs[x / chunk_size], chunk_size};
+        }
+        if (last < end) {
+          ready_regions[r.logical_offset + last - front].substr_of(
+            req.bl, last, end - last);
+        }
+      }
+    }
+  }
+
+  // walk the range in order: data, chunk crcs and zeroed holes
+  auto pr = ready_regions.begin();
+  auto pc = ready_crcs.begin();
+  uint64_t pos = offset;
+  const uint64_t end = offset + length;
+  while (pos < end) {
+    if (pr != ready_regions.end() && pr->first == pos) {
+      *crc = pr->second.crc32c(*crc);
+      pos += pr->second.length();
+      ++pr;
+    } else if (pc != ready_crcs.end() && pc->first == pos) {
+      // chunk crcs are seeded with -1
+      *crc = ceph_crc32c_combine(*crc ^ 0xffffffff, pc->second.first,
+				 pc->second.second);
+      pos += pc->second.second;
+      ++pc;
+    } else {
+      uint64_t next = end;
+      if (pr != ready_regions.end()) {
+        ceph_assert(pr->first > pos);
+        next = std::min(next, pr->first);
+      }
+      if (pc != ready_crcs.end()) {
+        ceph_assert(pc->first > pos);
+        next = std::min(next, pc->first);
+      }
+      dout(30) << __func__ << " zeros for 0x" << std::hex << pos << "~"
+               << (next - pos) << std::dec << dendl;
+      *crc = ceph_crc32c(*crc, nullptr, next - pos);
+      pos = next;
+    }
+  }
+  ceph_assert(pos == end);
+  ceph_assert(pr == ready_regions.end());
+  ceph_assert(pc == ready_crcs.end());
+  return 0;
+}
+
+int BlueStore::_do_read_crc32c(
+  Collection *c,
+  OnodeRef& o,
+  uint64_t offset,
+  size_t length,
+  uint32_t *crc,
+  uint32_t op_flags,
+  uint64_t retry_count)
+{
+  FUNCTRACE(cct);
+  int read_cache_policy = 0;
+
+  dout(20) << __func__ << " 0x" << std::hex << offset << "~" << length
+           << " size 0x" << o->onode.size << " (" << std::dec
+           << o->onode.size << ")" << dendl;
+
+  if (offset >= o->onode.size) {
+    return 0;
+  }
+  if (offset + length > o->onode.size) {
+    length = o->onode.size - offset;
+  }
+
+  o->extent_map.fault_range(db, offset, length);
+  _dump_onode<30>(cct, *o);
+
+  if (op_flags & CEPH_OSD_OP_FLAG_BYPASS_CLEAN_CACHE) {
+    read_cache_policy = BufferSpace::BYPASS_CLEAN_CACHE;
+  }
+
+  ready_regions_t ready_regions;
+  blobs2read_t blobs2read;
+  _read_cache(o, offset, length, read_cache_policy, ready_regions, blobs2read);
+
+  auto start = mono_clock::now();
+  vector<bufferlist> compressed_blob_bls;
+  IOContext ioc(cct, NULL, !cct->_conf->bluestore_fail_eio);
+  int r = _prepare_read_ioc(blobs2read, &compressed_blob_bls, &ioc);
+  if (r < 0)
+    return r;
+
+  int64_t num_ios = blobs2read.size();
+  if (ioc.has_pending_aios()) {
+    num_ios = ioc.get_num_ios();
+    bdev->aio_submit(&ioc);
+    dout(20) << __func__ << " waiting for aio" << dendl;
+    ioc.aio_wait();
+    r = ioc.get_return_value();
+    if (r < 0) {
+      ceph_assert(r == -EIO); // no other errors allowed
+      return -EIO;
+    }
+  }
+  log_latency_fn(__func__,
+    l_bluestore_read_wait_aio_lat,
+    mono_clock::now() - start,
+    cct->_conf->bluestore_log_op_age,
+    [&](auto lat) { return ", num_ios = " + stringify(num_ios); },
+    l_bluestore_slow_read_wait_aio_count
+  );
+
+  bool csum_error = false;
+  uint32_t result = *crc;
+  r = _generate_read_result_crc32c(o, offset, length, ready_regions,
+                                   compressed_blob_bls, blobs2read,
+                                   &csum_error, &result);
+  if (csum_error) {
+    // see _do_read
+    if (retry_count >= cct->_conf->bluestore_retry_disk_reads) {
+      return -EIO;
+    }
+    return _do_read_crc32c(c, o, offset, length, crc, op_flags,
+                           retry_count + 1);
+  }
+  if (r < 0)
+    return r;
+  *crc = result;
+  if (retry_count) {
+    logger->inc(l_bluestore_reads_with_retries);
+    dout(5) << __func__ << " read at 0x" << std::hex << offset << "~" << length
+            << " failed " << std::dec << retry_count << " times before succeeding" << dendl;
+    stringstream s;
+    s << " reads with retries: " << logger->get(l_bluestore_reads_with_retries);
+    _set_spurious_read_errors_alert(s.str());
+  }
+  return length;
+}
+
 int BlueStore::_verify_csum(OnodeRef& o,
 			    const bluestore_blob_t* blob, uint64_t blob_xoffset,
 			    const bufferlist& bl,
@@ -12387,6 +12665,46 @@ int BlueStore::fiemap(
   return r;
 }
 
+int BlueStore::get_device_offsets(
+  CollectionHandle &c_,
+  const vector<ghobject_t>& oids,
+  vector<uint64_t> *offsets)
+{
+  Collection *c = static_cast<Collection *>(c_.get());
+  if (!c->exists)
+    return -ENOENT;
+  offsets->assign(oids.size(), UINT64_MAX);
+  std::shared_lock l(c->lock);
+  for (size_t i = 0; i < oids.size(); ++i) {
+    OnodeRef o = c->get_onode(oids[i], false);
+    if (!o || !o->exists || o->onode.size == 0) {
+      continue;
+    }
+    // only the shard holding the first lextent is needed
+    o->extent_map.fault_range(db, 0, 1);
+    auto ep = o->extent_map.seek_lextent(0);
+    if (ep == o->extent_map.extent_map.end()) {
+      continue;
+    }
+    const bluestore_blob_t& blob = ep->blob->get_blob();
+    // a compressed blob is read as a whole; otherwise find the pextent
+    // backing the lextent's start
+    uint64_t x_off = blob.is_compressed() ? 0 : ep->blob_offset;
+    for (auto& p : blob.get_extents()) {
+      if (x_off < p.length) {
+	if (p.is_valid()) {
+	  (*offsets)[i] = p.offset + x_off;
+	}
+	break;
+      }
+      x_off -= p.length;
+    }
+  }
+  dout(20) << __func__ << " " << c->cid << " " << oids.size()
+	   << " objects" << dendl;
+  return 0;
+}
+
 int BlueStore::readv(
   CollectionHandle &c_,
   const ghobject_t& oid,
@@ -3118,6 +3118,13 @@ public:
     size_t len,
     ceph::buffer::list& bl,
     uint32_t op_flags = 0) override;
+  int read_crc32c(
+    CollectionHandle &c,
+    const ghobject_t& oid,
+    uint64_t offset,
+    size_t len,
+    uint32_t *crc,
+    uint32_t op_flags = 0) override;
 
 private:
 
@@ -3202,6 +3209,28 @@ private:
     uint32_t op_flags = 0,
     uint64_t retry_count = 0);
 
+  /// crc32c(-1, ...) of whole csum chunks, by logical offset: (crc, length)
+  typedef std::map<uint64_t, std::pair<uint32_t, uint32_t>> ready_crcs_t;
+
+  int _generate_read_result_crc32c(
+    OnodeRef& o,
+    uint64_t offset,
+    size_t length,
+    ready_regions_t& ready_regions,
+    std::vector<ceph::buffer::list>& compressed_blob_bls,
+    blobs2read_t& blobs2read,
+    bool* csum_error,
+    uint32_t *crc);
+
+  int _do_read_crc32c(
+    Collection *c,
+    OnodeRef& o,
+    uint64_t offset,
+    size_t len,
+    uint32_t *crc,
+    uint32_t op_flags = 0,
+    uint64_t retry_count = 0);
+
   int _do_readv(
     Collection *c,
     OnodeRef& o,
@@ -3217,6 +3246,10 @@ public:
 	     uint64_t offset, size_t len, ceph::buffer::list& bl) override;
   int fiemap(CollectionHandle &c, const ghobject_t& oid,
 	     uint64_t offset, size_t len, std::map<uint64_t, uint64_t>& destmap) override;
+  int get_device_offsets(
+    CollectionHandle &c,
+    const std::vector<ghobject_t>& oids,
+    std::vector<uint64_t> *offsets) override;
 
   int readv(
     CollectionHandle &c_,
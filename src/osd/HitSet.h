@@ -16,6 +16,7 @@
 #define CEPH_OSD_HITSET_H
 
 #include <string_view>
+#include <vector>
 
 #include <boost/scoped_ptr.hpp>
 
@@ -38,7 +39,8 @@ public:
     TYPE_NONE = 0,
     TYPE_EXPLICIT_HASH = 1,
     TYPE_EXPLICIT_OBJECT = 2,
-    TYPE_BLOOM = 3
+    TYPE_BLOOM = 3,
+    TYPE_BLOCKED_BLOOM = 4
   } impl_type_t;
 
   static std::string_view get_type_name(impl_type_t t) {
@@ -47,9 +49,14 @@ public:
     case TYPE_EXPLICIT_HASH: return "explicit_hash";
     case TYPE_EXPLICIT_OBJECT: return "explicit_object";
     case TYPE_BLOOM: return "bloom";
+    case TYPE_BLOCKED_BLOOM: return "blocked_bloom";
     default: return "???";
     }
   }
+  /// true if the Params of this type are a BloomHitSet::Params
+  static bool is_bloom_type(impl_type_t t) {
+    return t == TYPE_BLOOM || t == TYPE_BLOCKED_BLOOM;
+  }
   std::string_view get_type_name() const {
     if (impl)
       return get_type_name(impl->get_type());
@@ -452,4 +459,136 @@ public:
 };
 WRITE_CLASS_ENCODER(BloomHitSet)
 
+/**
+ * split block bloom filter
+ *
+ * BloomHitSet probes k bits scattered over the whole filter, so every
+ * insert and lookup on the op path touches k cache lines.  Here each
+ * object hashes to one 32 byte block, and sets one bit in each of the
+ * 8 words of that block, picked by multiplying the hash with a per
+ * word odd constant.  A probe is a single cache line, and the 8 lanes
+ * are independent, so the compiler turns them into one vector op.
+ *
+ * For the same number of bits the false positive rate is a little
+ * higher than with a classic bloom filter; the filter is sized for
+ * the requested fpp with that taken into account.
+ */
+class BlockedBloomHitSet : public HitSet::Impl {
+public:
+  static constexpr unsigned WORDS_PER_BLOCK = 8;
+
+  struct alignas(32) block_t {
+    uint32_t w[WORDS_PER_BLOCK] = {0};
+  };
+
+private:
+  uint64_t count = 0;        ///< number of inserts
+  uint64_t target_size = 0;  ///< we are full after this many inserts
+  uint64_t seed = 0;
+  std::vector<block_t> blocks;
+
+  static constexpr uint32_t salt[WORDS_PER_BLOCK] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+  };
+
+  uint64_t key_of(uint32_t hash) const {
+    // the object hash is only 32 bits; spread it (with the seed) over
+    // 64 so that the block and the in-block bits are independent
+    uint64_t k = (seed << 32) ^ hash;
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+  }
+  size_t block_of(uint64_t k) const {
+    // the high 32 bits of the key scaled to [0, blocks.size())
+    return ((k >> 32) * blocks.size()) >> 32;
+  }
+  static void make_mask(uint32_t k, uint32_t *mask) {
+    for (unsigned i = 0; i < WORDS_PER_BLOCK; ++i) {
+      mask[i] = 1u << ((k * salt[i]) >> 27);
+    }
+  }
+
+public:
+  class Params : public BloomHitSet::Params {
+  public:
+    using BloomHitSet::Params::Params;
+
+    HitSet::impl_type_t get_type() const override {
+      return HitSet::TYPE_BLOCKED_BLOOM;
+    }
+    HitSet::Impl *get_new_impl() const override {
+      return new BlockedBloomHitSet;
+    }
+    static void generate_test_instances(std::list<Params*>& o) {
+      o.push_back(new Params);
+      o.push_back(new Params(.05, 300, 99));
+    }
+  };
+
+  BlockedBloomHitSet() : blocks(1) {}
+  BlockedBloomHitSet(uint64_t inserts, double fpp, uint64_t seed);
+  explicit BlockedBloomHitSet(const BlockedBloomHitSet::Params *p)
+    : BlockedBloomHitSet(p->target_size, p->get_fpp(), p->seed) {}
+
+  HitSet::Impl *clone() const override {
+    return new BlockedBloomHitSet(*this);
+  }
+  HitSet::impl_type_t get_type() const override {
+    return HitSet::TYPE_BLOCKED_BLOOM;
+  }
+
+  bool is_full() const override {
+    return count >= target_size;
+  }
+  void insert(const hobject_t& o) override {
+    uint64_t k = key_of(o.get_hash());
+    uint32_t mask[WORDS_PER_BLOCK];
+    make_mask(k, mask);
+    block_t& b = blocks[block_of(k)];
+    for (unsigned i = 0; i < WORDS_PER_BLOCK; ++i) {
+      b.w[i] |= mask[i];
+    }
+    ++count;
+  }
+  bool contains(const hobject_t& o) const override {
+    uint64_t k = key_of(o.get_hash());
+    uint32_t mask[WORDS_PER_BLOCK];
+    make_mask(k, mask);
+    const block_t& b = blocks[block_of(k)];
+    uint32_t missing = 0;
+    for (unsigned i = 0; i < WORDS_PER_BLOCK; ++i) {
+      missing |= mask[i] & ~b.w[i];
+    }
+    return missing == 0;
+  }
+  unsigned insert_count() const override {
+    return count;
+  }
+  unsigned approx_unique_insert_count() const override;
+  /// size of the filter, in bytes
+  size_t get_size() const {
+    return blocks.size() * sizeof(block_t);
+  }
+  /// fraction of the bits that are set
+  double density() const;
+  void seal() override;
+
+  void encode(ceph::buffer::list &bl) const override;
+  void decode(ceph::buffer::list::const_iterator& bl) override;
+  void dump(ceph::Formatter *f) const override;
+  static void generate_test_instances(std::list<BlockedBloomHitSet*>& o) {
+    o.push_back(new BlockedBloomHitSet);
+    o.push_back(new BlockedBloomHitSet(10, .1, 1));
+    o.back()->insert(hobject_t());
+    o.back()->insert(hobject_t("asdf", "", CEPH_NOSNAP, 123, 1, ""));
+    o.back()->insert(hobject_t("qwer", "", CEPH_NOSNAP, 456, 1, ""));
+  }
+};
+WRITE_CLASS_ENCODER(BlockedBloomHitSet)
+
 #endif
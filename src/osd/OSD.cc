@@ -1049,6 +1049,7 @@ osd_stat_t OSDService::set_osd_stat(vector<int>& hb_peers,
       dout(20) << __func__ << " time out heartbeat for osd " << i.first
 	       << " last_update " << i.second.last_update << dendl;
       osd_stat.hb_pingtime.erase(i.first);
+      hb_hists.erase(i.first);
       break;
     }
   }
@@ -2848,6 +2849,10 @@ will start to track new ops received afterwards.";
 	goto out;
       }
     }
+  } else if (prefix == "dump_op_stage_histograms") {
+    f->open_object_section("op_tracker");
+    op_tracker.dump_stage_histograms(f);
+    f->close_section();
   } else if (prefix == "dump_op_pq_state") {
     f->open_object_section("pq");
     op_shardedwq.dump(f);
@@ -3252,6 +3257,7 @@ will start to track new ops received afterwards.";
       std::array<uint32_t,3> max;
       uint32_t last;
       uint32_t last_update;
+      pow2_hist_fixed_t hist;
 
       bool operator<(const osd_ping_time_t& rhs) const {
 	if (pingtime < rhs.pingtime)
@@ -3269,7 +3275,8 @@ will start to track new ops received afterwards.";
     set<osd_ping_time_t> sorted;
     // Get pingtimes under lock and not on the stack
     map<int, osd_stat_t::Interfaces> *pingtimes = new map<int, osd_stat_t::Interfaces>;
-    service.get_hb_pingtime(pingtimes);
+    map<int, std::pair<pow2_hist_fixed_t, pow2_hist_fixed_t>> hists;
+    service.get_hb_pingtime(pingtimes, &hists);
     for (auto j : *pingtimes) {
       if (j.second.last_update == 0)
 	continue;
@@ -3290,6 +3297,9 @@ will start to track new ops received afterwards.";
 	item.last = j.second.back_last;
 	item.back = true;
 	item.last_update = j.second.last_update;
+	if (auto h = hists.find(j.first); h != hists.end()) {
+	  item.hist = h->second.first;
+	}
 	sorted.emplace(item);
       }
       if (j.second.front_last == 0)
@@ -3310,6 +3320,11 @@ will start to track new ops received afterwards.";
 	item.last = j.second.front_last;
 	item.last_update = j.second.last_update;
 	item.back = false;
+	if (auto h = hists.find(j.first); h != hists.end()) {
+	  item.hist = h->second.second;
+	} else {
+	  item.hist.clear();
+	}
 	sorted.emplace(item);
       }
     }
@@ -3349,6 +3364,16 @@ will start to track new ops received afterwards.";
       f->dump_format_unquoted("15min", "%s", fixed_u_to_string(sitem.max[2],3).c_str());
       f->close_section();  // max
       f->dump_format_unquoted("last", "%s", fixed_u_to_string(sitem.last,3).c_str());
+      if (!sitem.hist.empty()) {
+	f->open_object_section("percentile");
+	f->dump_format_unquoted("p50", "%s", fixed_u_to_string(sitem.hist.get_percentile_upper_bound(50),3).c_str());
+	f->dump_format_unquoted("p90", "%s", fixed_u_to_string(sitem.hist.get_percentile_upper_bound(90),3).c_str());
+	f->dump_format_unquoted("p99", "%s", fixed_u_to_string(sitem.hist.get_percentile_upper_bound(99),3).c_str());
+	f->close_section();  // percentile
+	f->open_object_section("histogram_usec");
+	sitem.hist.dump(f);
+	f->close_section();  // histogram_usec
+      }
       f->close_section();  // entry
     }
     f->close_section(); // entries
@@ -4157,6 +4182,10 @@ void OSD::final_init()
 				     asok_hook,
 				     "show slowest recent ops, sorted by duration");
   ceph_assert(r == 0);
+  r = admin_socket->register_command("dump_op_stage_histograms",
+				     asok_hook,
+				     "show latency histograms of completed ops by stage");
+  ceph_assert(r == 0);
   r = admin_socket->register_command("dump_op_pq_state",
 				     asok_hook,
 				     "dump op queue state");
@@ -5986,6 +6015,13 @@ void OSD::handle_osd_ping(MOSDPing *m)
 		std::lock_guard l(service.stat_lock);
 		service.osd_stat.hb_pingtime[from].last_update = now.sec();
 		service.osd_stat.hb_pingtime[from].back_last =  back_pingtime;
+		auto& hists = service.hb_hists[from];
+		hists.first.add(back_pingtime);
+		hists.first.decay();
+		if (i->second.con_front != NULL) {
+		  hists.second.add(front_pingtime);
+		  hists.second.decay();
+		}
 
 		uint32_t total = 0;
 		uint32_t min = UINT_MAX;
@@ -6041,8 +6077,12 @@ void OSD::handle_osd_ping(MOSDPing *m)
 	    } else {
 		std::lock_guard l(service.stat_lock);
 		service.osd_stat.hb_pingtime[from].back_last =  back_pingtime;
-                if (i->second.con_front != NULL)
+		auto& hists = service.hb_hists[from];
+		hists.first.add(back_pingtime);
+                if (i->second.con_front != NULL) {
 		  service.osd_stat.hb_pingtime[from].front_last = front_pingtime;
+		  hists.second.add(front_pingtime);
+		}
 	    }
             i->second.ping_history.erase(i->second.ping_history.begin(), ++acked);
           }
@@ -10625,6 +10665,7 @@ int OSDShard::_wake_pg_slot(
   }
   slot->waiting_peering.clear();
   ++slot->requeue_seq;
+  queue_depth += count;
   return count;
 }
 
@@ -10896,6 +10937,17 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
 
   // peek at spg_t
   sdata->shard_lock.lock();
+  if (m_work_stealing &&
+      sdata->scheduler->empty() &&
+      (!is_smallest_thread_index || sdata->context_queue.empty())) {
+    // nothing to do here; help out a backlogged shard before parking.
+    // never hold two shard_locks at once.
+    sdata->shard_lock.unlock();
+    if (_steal(shard_index, hb)) {
+      return;
+    }
+    sdata->shard_lock.lock();
+  }
   if (sdata->scheduler->empty() &&
       (!is_smallest_thread_index || sdata->context_queue.empty())) {
     std::unique_lock wait_lock{sdata->sdata_wait_lock};
@@ -10906,7 +10958,9 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
       dout(20) << __func__ << " empty q, waiting" << dendl;
       osd->cct->get_heartbeat_map()->clear_timeout(hb);
       sdata->shard_lock.unlock();
+      ++sdata->idle_threads;
       sdata->sdata_cond.wait(wait_lock);
+      --sdata->idle_threads;
       wait_lock.unlock();
       sdata->shard_lock.lock();
       if (sdata->scheduler->empty() &&
@@ -10947,6 +11001,9 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
     }
 
     work_item = sdata->scheduler->dequeue();
+    if (std::holds_alternative<OpSchedulerItem>(work_item)) {
+      --sdata->queue_depth;
+    }
     if (osd->is_stopping()) {
       sdata->shard_lock.unlock();
       for (auto c : oncommits) {
@@ -10997,6 +11054,16 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
     return;    // OSD shutdown, discard.
   }
 
+  _process_item(sdata, std::move(item), oncommits, hb);
+}
+
+void OSD::ShardedOpWQ::_process_item(
+  OSDShard *sdata,
+  OpSchedulerItem&& item,
+  list<Context*>& oncommits,
+  heartbeat_handle_d *hb)
+{
+  const uint32_t shard_index = sdata->shard_id;
   const auto token = item.get_ordering_token();
   auto r = sdata->pg_slots.emplace(token, nullptr);
   if (r.second) {
@@ -11220,6 +11287,58 @@ void OSD::ShardedOpWQ::_process(uint32_t thread_index, heartbeat_handle_d *hb)
   handle_oncommits(oncommits);
 }
 
+bool OSD::ShardedOpWQ::_steal(uint32_t shard_index,
+			      heartbeat_handle_d *hb)
+{
+  const uint32_t num_shards = osd->num_shards;
+  for (uint32_t i = 1; i < num_shards; ++i) {
+    auto sdata = osd->shards[(shard_index + i) % num_shards];
+    if (sdata->idle_threads.load() > 0) {
+      // the owner has threads of its own to spare
+      continue;
+    }
+    std::unique_lock l{sdata->shard_lock, std::try_to_lock};
+    if (!l.owns_lock() || sdata->scheduler->empty()) {
+      continue;
+    }
+    auto work_item = sdata->scheduler->dequeue();
+    if (!std::holds_alternative<OpSchedulerItem>(work_item)) {
+      // only future work; leave it to the owning shard's timed wait
+      continue;
+    }
+    --sdata->queue_depth;
+    ++sdata->num_stolen;
+    if (osd->is_stopping()) {
+      return true;    // OSD shutdown, discard.
+    }
+    auto item = std::move(std::get<OpSchedulerItem>(work_item));
+    dout(20) << __func__ << " shard " << shard_index << " stole " << item
+	     << " from shard " << sdata->shard_id << dendl;
+    osd->logger->inc(l_osd_op_wq_steal);
+    // the slot and pg lock of the owning shard keep the item ordered
+    // relative to anything its own threads are processing.  we never
+    // run the owner's oncommits: only its lowest thread may do that.
+    l.release();
+    list<Context*> oncommits;
+    _process_item(sdata, std::move(item), oncommits, hb);
+    return true;
+  }
+  return false;
+}
+
+void OSD::ShardedOpWQ::_wake_stealer(uint32_t shard_index)
+{
+  const uint32_t num_shards = osd->num_shards;
+  for (uint32_t i = 1; i < num_shards; ++i) {
+    auto sdata = osd->shards[(shard_index + i) % num_shards];
+    if (sdata->idle_threads.load() > 0) {
+      std::lock_guard l{sdata->sdata_wait_lock};
+      sdata->sdata_cond.notify_one();
+      return;
+    }
+  }
+}
+
 void OSD::ShardedOpWQ::_enqueue(OpSchedulerItem&& item) {
   if (unlikely(m_fast_shutdown) ) {
     // stop enqueing when we are in the middle of a fast shutdown
@@ -11235,11 +11354,14 @@ void OSD::ShardedOpWQ::_enqueue(OpSchedulerItem&& item) {
   dout(20) << fmt::format("{} {}", __func__, item) << dendl;
 
   bool empty = true;
+  unsigned depth;
   {
     std::lock_guard l{sdata->shard_lock};
     empty = sdata->scheduler->empty();
     sdata->scheduler->enqueue(std::move(item));
+    depth = ++sdata->queue_depth;
   }
+  osd->logger->hinc(l_osd_op_wq_depth_hist, depth, shard_index);
 
   {
     std::lock_guard l{sdata->sdata_wait_lock};
@@ -11249,6 +11371,11 @@ void OSD::ShardedOpWQ::_enqueue(OpSchedulerItem&& item) {
       sdata->sdata_cond.notify_one();
     }
   }
+
+  if (m_work_stealing && !empty && sdata->idle_threads.load() == 0) {
+    // our own threads are all busy; let an idle peer help
+    _wake_stealer(shard_index);
+  }
 }
 
 void OSD::ShardedOpWQ::_enqueue_front(OpSchedulerItem&& item)
@@ -11279,6 +11406,7 @@ void OSD::ShardedOpWQ::_enqueue_front(OpSchedulerItem&& item)
     dout(20) << __func__ << " " << item << dendl;
   }
   sdata->scheduler->enqueue_front(std::move(item));
+  ++sdata->queue_depth;
   sdata->shard_lock.unlock();
   std::lock_guard l{sdata->sdata_wait_lock};
   sdata->sdata_cond.notify_one();
@@ -11295,6 +11423,7 @@ void OSD::ShardedOpWQ::stop_for_fast_shutdown()
     while (!sdata->scheduler->empty()) {
       sdata->scheduler->dequeue();
     }
+    sdata->queue_depth = 0;
   }
 }
 
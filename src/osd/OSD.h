@@ -745,10 +745,16 @@ public:
     std::lock_guard l(stat_lock);
     return osd_stat.seq;
   }
-  void get_hb_pingtime(std::map<int, osd_stat_t::Interfaces> *pp)
+  /// back and front ping times in usec of each heartbeat peer, halved at
+  /// the end of every averaging interval; protected by stat_lock
+  std::map<int, std::pair<pow2_hist_fixed_t, pow2_hist_fixed_t>> hb_hists;
+  void get_hb_pingtime(std::map<int, osd_stat_t::Interfaces> *pp,
+    std::map<int, std::pair<pow2_hist_fixed_t, pow2_hist_fixed_t>> *hists = nullptr)
   {
     std::lock_guard l(stat_lock);
     *pp = osd_stat.hb_pingtime;
+    if (hists)
+      *hists = hb_hists;
     return;
   }
 
@@ -979,6 +985,9 @@ struct OSDShard {
   ceph::mutex sdata_wait_lock;
   ceph::condition_variable sdata_cond;
   int waiting_threads = 0;
+  /// threads parked on sdata_cond because the shard is empty; read without
+  /// sdata_wait_lock by work-stealing peers looking for someone to wake
+  std::atomic<int> idle_threads = {0};
 
   ceph::mutex osdmap_lock;  ///< protect shard_osdmap updates vs users w/o shard_lock
   OSDMapRef shard_osdmap;
@@ -1015,6 +1024,10 @@ struct OSDShard {
 
   /// priority queue
   ceph::osd::scheduler::OpSchedulerRef scheduler;
+  /// number of items currently held by scheduler
+  unsigned queue_depth = 0;
+  /// number of items dequeued from this shard by other shards' threads
+  uint64_t num_stolen = 0;
 
   bool stop_waiting = false;
 
@@ -1555,13 +1568,16 @@ protected:
   {
     OSD *osd;
     bool m_fast_shutdown = false;
+    const bool m_work_stealing;
   public:
     ShardedOpWQ(OSD *o,
 		ceph::timespan ti,
 		ceph::timespan si,
 		ShardedThreadPool* tp)
       : ShardedThreadPool::ShardedWQ<OpSchedulerItem>(ti, si, tp),
-        osd(o) {
+        osd(o),
+        m_work_stealing(
+	  o->cct->_conf.get_val<bool>("osd_op_queue_work_stealing")) {
     }
 
     void _add_slot_waiter(
@@ -1572,6 +1588,20 @@ protected:
     /// try to do some work
     void _process(uint32_t thread_index, ceph::heartbeat_handle_d *hb) override;
 
+    /// queue item to its PG slot and run the slot's next item (shard_lock
+    /// held on entry, dropped on return)
+    void _process_item(
+      OSDShard *sdata,
+      OpSchedulerItem&& item,
+      std::list<Context*>& oncommits,
+      ceph::heartbeat_handle_d *hb);
+
+    /// run one item from another shard's backlog; false if none was found
+    bool _steal(uint32_t shard_index, ceph::heartbeat_handle_d *hb);
+
+    /// wake an idle thread of another shard so it can steal from us
+    void _wake_stealer(uint32_t shard_index);
+
     void stop_for_fast_shutdown();
 
     /// enqueue a new item
@@ -1610,6 +1640,8 @@ protected:
 	std::scoped_lock l{sdata->shard_lock};
 	f->open_object_section(queue_name);
 	sdata->scheduler->dump(*f);
+	f->dump_unsigned("queue_depth", sdata->queue_depth);
+	f->dump_unsigned("num_stolen", sdata->num_stolen);
 	f->close_section();
       }
     }
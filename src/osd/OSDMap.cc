@@ -1793,8 +1793,13 @@ uint64_t OSDMap::get_features(int entity_type, uint64_t *pmask) const
       if (crush->is_msr_rule(ruleid))
 	features |= CEPH_FEATURE_CRUSH_MSR;
     }
+    if (pool.second.hit_set_params.get_type() == HitSet::TYPE_BLOCKED_BLOOM) {
+      // pg_pool_t carries the hit set params; nobody else can decode them
+      features |= CEPH_FEATUREMASK_OSD_HITSET_BLOCKED_BLOOM;
+    }
   }
-  mask |= CEPH_FEATURE_OSDHASHPSPOOL | CEPH_FEATURE_OSD_CACHEPOOL;
+  mask |= CEPH_FEATURE_OSDHASHPSPOOL | CEPH_FEATURE_OSD_CACHEPOOL |
+    CEPH_FEATURE_OSD_HITSET_BLOCKED_BLOOM;
 
   if (osd_primary_affinity) {
     for (int i = 0; i < max_osd; ++i) {
@@ -1846,7 +1851,8 @@ ceph_release_t OSDMap::get_min_compat_client() const
 {
   uint64_t f = get_features(CEPH_ENTITY_TYPE_CLIENT, nullptr);
 
-  if (HAVE_FEATURE(f, CRUSH_MSR)) {
+  if (HAVE_FEATURE(f, CRUSH_MSR) ||
+      HAVE_FEATURE(f, OSD_HITSET_BLOCKED_BLOOM)) {
     return ceph_release_t::squid;        // v19.2.0
   }
   if (HAVE_FEATURE(f, OSDMAP_PG_UPMAP) ||      // v12.0.0-1733-g27d6f43
@@ -2970,6 +2976,54 @@ void OSDMap::_pg_to_up_acting_osds(
     *acting_primary = _acting_primary;
 }
 
+void OSDMap::pg_range_to_up_acting_osds(
+  int64_t poolid, ps_t ps_begin, ps_t ps_end,
+  std::function<void(ps_t ps,
+		     vector<int>&& up, int up_primary,
+		     vector<int>&& acting, int acting_primary)> f) const
+{
+  const pg_pool_t *pool = get_pg_pool(poolid);
+  ceph_assert(pool);
+  // bounds the raw crush output buffer held at a time
+  constexpr ps_t batch = 1024;
+  int ruleno = pool->get_crush_rule();
+  vector<int> xs;
+  vector<vector<int>> raws;
+  for (ps_t first = ps_begin; first < ps_end; first += batch) {
+    ps_t last = std::min<ps_t>(ps_end, first + batch);
+    xs.clear();
+    for (ps_t ps = first; ps < last; ++ps) {
+      xs.push_back(pool->raw_pg_to_pps(pg_t(ps, poolid)));
+    }
+    if (ruleno >= 0) {
+      crush->do_rule_batch(ruleno, xs, raws, pool->get_size(), osd_weight,
+			   poolid);
+    } else {
+      raws.assign(xs.size(), {});
+    }
+    for (ps_t ps = first; ps < last; ++ps) {
+      pg_t pg(ps, poolid);
+      ps_t pps = xs[ps - first];
+      vector<int>& raw = raws[ps - first];
+      vector<int> up, acting;
+      int up_primary, acting_primary;
+      _remove_nonexistent_osds(*pool, raw);
+      _get_temp_osds(*pool, pg, &acting, &acting_primary);
+      _apply_upmap(*pool, pg, &raw);
+      _raw_to_up_osds(*pool, raw, &up);
+      up_primary = _pick_primary(up);
+      _apply_primary_affinity(pps, *pool, &up, &up_primary);
+      if (acting.empty()) {
+	acting = up;
+	if (acting_primary == -1) {
+	  acting_primary = up_primary;
+	}
+      }
+      f(ps, std::move(up), up_primary, std::move(acting), acting_primary);
+    }
+  }
+}
+
 int OSDMap::calc_pg_role_broken(int osd, const vector<int>& acting, int nrep)
 {
   // This implementation is broken for EC PGs since the osd may appear
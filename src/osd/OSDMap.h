@@ -29,6 +29,7 @@
 #include <set>
 #include <map>
 #include <memory>
+#include <functional>
 
 #include <boost/smart_ptr/local_shared_ptr.hpp>
 #include "include/btree_map.h"
@@ -1300,6 +1301,19 @@ public:
     int up_primary, acting_primary;
     pg_to_up_acting_osds(pg, &up, &up_primary, &acting, &acting_primary);
   }
+  /**
+   * map pgs [ps_begin, ps_end) of a pool to their up and acting sets
+   *
+   * Same result as pg_to_up_acting_osds() for each pg, but the CRUSH
+   * step is done in batches that share one workspace, which is what
+   * you want when (re)computing the mapping of a whole pool.  f is
+   * called in ps order.
+   */
+  void pg_range_to_up_acting_osds(
+    int64_t poolid, ps_t ps_begin, ps_t ps_end,
+    std::function<void(ps_t ps,
+		       std::vector<int>&& up, int up_primary,
+		       std::vector<int>&& acting, int acting_primary)> f) const;
   bool pg_is_ec(pg_t pg) const {
     auto i = pools.find(pg.pool());
     ceph_assert(i != pools.end());
@@ -71,7 +71,7 @@ void OpRequest::_dump(Formatter *f) const
 
     for (auto i = events.begin(); i != events.end(); ++i) {
       f->open_object_section("event");
-      f->dump_string("event", i->str);
+      f->dump_string("event", i->name());
       f->dump_stream("time") << i->stamp;
 
       double duration = 0;
@@ -129,6 +129,19 @@ void OpRequest::mark_flag_point(uint8_t flag, const char *s) {
 	     flag, s, old_flags, hit_flag_points);
 }
 
+void OpRequest::mark_flag_point(uint8_t flag, op_stage_t stage) {
+#ifdef WITH_LTTNG
+  uint8_t old_flags = hit_flag_points;
+#endif
+  mark_event(stage);
+  last_event_detail = op_stage_name(stage);
+  hit_flag_points |= flag;
+  latest_flag_point = flag;
+  tracepoint(oprequest, mark_flag_point, reqid.name._type,
+	     reqid.name._num, reqid.tid, reqid.inc, op_info.get_flags(),
+	     flag, last_event_detail, old_flags, hit_flag_points);
+}
+
 void OpRequest::mark_flag_point_string(uint8_t flag, const string& s) {
 #ifdef WITH_LTTNG
   uint8_t old_flags = hit_flag_points;
@@ -737,6 +737,8 @@ void PG::clear_recovery_state()
 
   backfill_info.clear();
   peer_backfill_info.clear();
+  peer_backfill_prefetch.clear();
+  peer_backfill_prefetching.clear();
   waiting_on_backfill.clear();
   _clear_recovery_state();  // pg impl specific hook
 }
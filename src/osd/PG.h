@@ -889,6 +889,10 @@ protected:
 protected:
   BackfillInterval backfill_info;
   std::map<pg_shard_t, BackfillInterval> peer_backfill_info;
+  /// next interval of each backfill target, scanned ahead of need
+  std::map<pg_shard_t, BackfillInterval> peer_backfill_prefetch;
+  /// backfill targets with a prefetch scan in flight, and where it begins
+  std::map<pg_shard_t, hobject_t> peer_backfill_prefetching;
   bool backfill_reserving;
 
   // The primary's num_bytes and local num_bytes for this pg, only valid
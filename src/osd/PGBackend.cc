@@ -16,6 +16,8 @@
  */
 
 
+#include <numeric>
+
 #include "common/errno.h"
 #include "common/scrub_types.h"
 #include "ReplicatedBackend.h"
@@ -606,6 +608,37 @@ PGBackend *PGBackend::build_pg_backend(
   }
 }
 
+void PGBackend::be_sort_by_device_offset(vector<hobject_t> &ls)
+{
+  vector<ghobject_t> oids;
+  oids.reserve(ls.size());
+  for (auto& hoid : ls) {
+    oids.emplace_back(
+      hoid, ghobject_t::NO_GEN, get_parent()->whoami_shard().shard);
+  }
+  vector<uint64_t> offsets;
+  int r = store->get_device_offsets(ch, oids, &offsets);
+  if (r < 0) {
+    dout(20) << __func__ << " not supported by store: " << r << dendl;
+    return;
+  }
+  ceph_assert(offsets.size() == ls.size());
+  // objects without a known location keep their listing order at the end
+  vector<size_t> order(ls.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+		   [&offsets](size_t a, size_t b) {
+		     return offsets[a] < offsets[b];
+		   });
+  vector<hobject_t> sorted;
+  sorted.reserve(ls.size());
+  for (auto i : order) {
+    sorted.push_back(std::move(ls[i]));
+  }
+  ls.swap(sorted);
+  dout(20) << __func__ << " sorted " << ls.size() << " objects" << dendl;
+}
+
 int PGBackend::be_scan_list(
   ScrubMap &map,
   ScrubMapBuilder &pos)
@@ -565,6 +565,7 @@ typedef std::shared_ptr<const OSDMap> OSDMapRef;
      Context *on_complete, bool fast_read = false) = 0;
 
    virtual bool auto_repair_supported() const = 0;
+   void be_sort_by_device_offset(std::vector<hobject_t> &ls);
    int be_scan_list(
      ScrubMap &map,
      ScrubMapBuilder &pos);
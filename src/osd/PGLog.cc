@@ -15,6 +15,8 @@
  *
  */
 
+#include <algorithm>
+
 #include "PGLog.h"
 #include "include/unordered_map.h"
 #include "common/ceph_context.h"
@@ -24,6 +26,7 @@ using std::map;
 using std::ostream;
 using std::set;
 using std::string;
+using std::vector;
 
 using ceph::bufferlist;
 using ceph::decode;
@@ -873,17 +876,37 @@ void PGLog::_write_log_and_missing(
 		     << " write_from_dups=" << write_from_dups
 		     << " trimmed_dups.size()=" << trimmed_dups.size() << dendl;
   set<string> to_remove;
-  to_remove.swap(trimmed_dups);
-  for (auto& t : trimmed) {
-    string key = t.get_key_name();
-    if (log_keys_debug) {
-      auto it = log_keys_debug->find(key);
+  if (log_keys_debug) {
+    for (auto& v : trimmed) {
+      auto it = log_keys_debug->find(v.get_key_name());
       ceph_assert(it != log_keys_debug->end());
       log_keys_debug->erase(it);
     }
-    to_remove.emplace(std::move(key));
+  }
+  // Trimming only ever removes the oldest entries and dups, so what we
+  // trimmed is a contiguous prefix of the on-disk keys.  Remove it with
+  // one range delete instead of a key per entry; the kv store turns
+  // large ranges into a single tombstone.
+  if (trimmed.size() > 1) {
+    const auto& last = *trimmed.rbegin();
+    t.omap_rmkeyrange(
+      coll, log_oid,
+      trimmed.begin()->get_key_name(),
+      eversion_t(last.epoch, last.version + 1).get_key_name());
+  } else if (!trimmed.empty()) {
+    to_remove.emplace(trimmed.begin()->get_key_name());
   }
   trimmed.clear();
+  if (trimmed_dups.size() > 1) {
+    // dup keys share a fixed length, so appending a NUL gives the
+    // smallest key past the last one
+    string end = *trimmed_dups.rbegin();
+    end.push_back('\0');
+    t.omap_rmkeyrange(coll, log_oid, *trimmed_dups.begin(), end);
+  } else {
+    to_remove.swap(trimmed_dups);
+  }
+  trimmed_dups.clear();
 
   if (touch_log)
     t.touch(coll, log_oid);
@@ -1032,19 +1055,22 @@ void PGLog::rebuild_missing_set_with_deletes(
 
   // go through the log and add items that are not present or older
   // versions on disk, just as if we were reading the log + metadata
-  // off disk originally
-  set<hobject_t> did;
-  for (auto i = log.log.rbegin();
-       i != log.log.rend();
-       ++i) {
-    if (i->version <= info.last_complete)
-      break;
-    if (i->soid > info.last_backfill ||
-	i->is_error() ||
-	did.find(i->soid) != did.end())
+  // off disk originally.  Only the newest entry of each object matters,
+  // which is what the object index points at; check them in object
+  // order so the store is walked sequentially.
+  vector<const pg_log_entry_t*> newest;
+  for (const auto& [soid, entry] : log.indexed_objects()) {
+    if (entry->version <= info.last_complete ||
+	soid > info.last_backfill)
       continue;
-    did.insert(i->soid);
+    newest.push_back(entry);
+  }
+  std::sort(newest.begin(), newest.end(),
+	    [](const pg_log_entry_t *a, const pg_log_entry_t *b) {
+	      return a->soid < b->soid;
+	    });
 
+  for (const auto i : newest) {
     bufferlist bv;
     int r = store->getattr(
       ch,
@@ -20,6 +20,7 @@
 #include "include/ceph_assert.h"
 #include "include/common_fwd.h"
 #include "osd_types.h"
+#include "PGLogIndex.h"
 #include "os/ObjectStore.h"
 #include <list>
 
@@ -146,10 +147,11 @@ public:
    * plus some methods to manipulate it all.
    */
   struct IndexedLog : public pg_log_t {
-    mutable ceph::unordered_map<hobject_t,pg_log_entry_t*> objects;  // ptrs into log.  be careful!
-    mutable ceph::unordered_map<osd_reqid_t,pg_log_entry_t*> caller_ops;
+    // ptrs into log.  be careful!
+    mutable PGLogIndex<pg_log_entry_t, hobject_t, &pg_log_entry_t::soid> objects;
+    mutable PGLogIndex<pg_log_entry_t, osd_reqid_t, &pg_log_entry_t::reqid> caller_ops;
     mutable ceph::unordered_multimap<osd_reqid_t,pg_log_entry_t*> extra_caller_ops;
-    mutable ceph::unordered_map<osd_reqid_t,pg_log_dup_t*> dup_index;
+    mutable PGLogIndex<pg_log_dup_t, osd_reqid_t, &pg_log_dup_t::reqid> dup_index;
 
     // recovery pointers
     std::list<pg_log_entry_t>::iterator complete_to; // not inclusive of referenced item
@@ -316,6 +318,14 @@ public:
       last_requested = 0;
     }
 
+    /// newest non-error entry of each logged object, in no particular order
+    const auto& indexed_objects() const {
+      if (!(indexed_data & PGLOG_INDEXED_OBJECTS)) {
+         index_objects();
+      }
+      return objects;
+    }
+
     bool logged_object(const hobject_t& oid) const {
       if (!(indexed_data & PGLOG_INDEXED_OBJECTS)) {
          index_objects();
@@ -363,20 +373,20 @@ public:
       if (!(indexed_data & PGLOG_INDEXED_EXTRA_CALLER_OPS)) {
         index_extra_caller_ops();
       }
-      p = extra_caller_ops.find(r);
-      if (p != extra_caller_ops.end()) {
+      auto q = extra_caller_ops.find(r);
+      if (q != extra_caller_ops.end()) {
 	uint32_t idx = 0;
-	for (auto i = p->second->extra_reqids.begin();
-	     i != p->second->extra_reqids.end();
+	for (auto i = q->second->extra_reqids.begin();
+	     i != q->second->extra_reqids.end();
 	     ++idx, ++i) {
 	  if (i->first == r) {
-	    *version = p->second->version;
+	    *version = q->second->version;
 	    *user_version = i->second;
-	    *return_code = p->second->return_code;
-	    *op_returns = p->second->op_returns;
+	    *return_code = q->second->return_code;
+	    *op_returns = q->second->op_returns;
 	    if (*return_code >= 0) {
-	      auto it = p->second->extra_reqid_return_codes.find(idx);
-	      if (it != p->second->extra_reqid_return_codes.end()) {
+	      auto it = q->second->extra_reqid_return_codes.find(idx);
+	      if (it != q->second->extra_reqid_return_codes.end()) {
 		*return_code = it->second;
 	      }
 	    }
@@ -389,12 +399,12 @@ public:
       if (!(indexed_data & PGLOG_INDEXED_DUPS)) {
         index_dups();
       }
-      auto q = dup_index.find(r);
-      if (q != dup_index.end()) {
-	*version = q->second->version;
-	*user_version = q->second->user_version;
-	*return_code = q->second->return_code;
-	*op_returns = q->second->op_returns;
+      auto d = dup_index.find(r);
+      if (d != dup_index.end()) {
+	*version = d->second->version;
+	*user_version = d->second->user_version;
+	*return_code = d->second->return_code;
+	*op_returns = d->second->op_returns;
 	return true;
       }
 
@@ -450,16 +460,21 @@ public:
       // IndexedLog (and indirectly through assignment operator)
       if (!to_index) return;
 
-      if (to_index & PGLOG_INDEXED_OBJECTS)
+      if (to_index & PGLOG_INDEXED_OBJECTS) {
 	objects.clear();
-      if (to_index & PGLOG_INDEXED_CALLER_OPS)
+	objects.reserve(log.size());
+      }
+      if (to_index & PGLOG_INDEXED_CALLER_OPS) {
 	caller_ops.clear();
+	caller_ops.reserve(log.size());
+      }
       if (to_index & PGLOG_INDEXED_EXTRA_CALLER_OPS)
 	extra_caller_ops.clear();
       if (to_index & PGLOG_INDEXED_DUPS) {
 	dup_index.clear();
+	dup_index.reserve(dups.size());
 	for (auto& i : dups) {
-	  dup_index[i.reqid] = const_cast<pg_log_dup_t*>(&i);
+	  dup_index.insert_or_assign(const_cast<pg_log_dup_t*>(&i));
 	}
       }
 
@@ -472,13 +487,13 @@ public:
 	for (auto i = log.begin(); i != log.end(); ++i) {
 	  if (to_index & PGLOG_INDEXED_OBJECTS) {
 	    if (i->object_is_indexed()) {
-	      objects[i->soid] = const_cast<pg_log_entry_t*>(&(*i));
+	      objects.insert_or_assign(const_cast<pg_log_entry_t*>(&(*i)));
 	    }
 	  }
 
 	  if (to_index & PGLOG_INDEXED_CALLER_OPS) {
 	    if (i->reqid_is_indexed()) {
-	      caller_ops[i->reqid] = const_cast<pg_log_entry_t*>(&(*i));
+	      caller_ops.insert_or_assign(const_cast<pg_log_entry_t*>(&(*i)));
 	    }
 	  }
 
@@ -514,14 +529,15 @@ public:
 
     void index(pg_log_entry_t& e) {
       if ((indexed_data & PGLOG_INDEXED_OBJECTS) && e.object_is_indexed()) {
-        if (objects.count(e.soid) == 0 ||
-            objects[e.soid]->version < e.version)
-          objects[e.soid] = &e;
+	auto it = objects.find(e.soid);
+        if (it == objects.end() ||
+            it->second->version < e.version)
+          objects.insert_or_assign(&e);
       }
       if (indexed_data & PGLOG_INDEXED_CALLER_OPS) {
 	// divergent merge_log indexes new before unindexing old
         if (e.reqid_is_indexed()) {
-	  caller_ops[e.reqid] = &e;
+	  caller_ops.insert_or_assign(&e);
         }
       }
       if (indexed_data & PGLOG_INDEXED_EXTRA_CALLER_OPS) {
@@ -574,7 +590,7 @@ public:
 
     void index(pg_log_dup_t& e) {
       if (indexed_data & PGLOG_INDEXED_DUPS) {
-	dup_index[e.reqid] = &e;
+	dup_index.insert_or_assign(&e);
       }
     }
 
@@ -609,11 +625,11 @@ public:
 
       // to our index
       if ((indexed_data & PGLOG_INDEXED_OBJECTS) && e.object_is_indexed()) {
-        objects[e.soid] = &(log.back());
+        objects.insert_or_assign(&(log.back()));
       }
       if (indexed_data & PGLOG_INDEXED_CALLER_OPS) {
         if (e.reqid_is_indexed()) {
-	  caller_ops[e.reqid] = &(log.back());
+	  caller_ops.insert_or_assign(&(log.back()));
         }
       }
 
@@ -0,0 +1,217 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation.  See file COPYING.
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#include "include/ceph_assert.h"
+#include "include/mempool.h"
+
+/**
+ * PGLogIndex - compact index over pg log entries
+ *
+ * IndexedLog used to index the log with node based unordered_maps
+ * keyed by a copy of the entry's soid or reqid.  For an hobject_t key
+ * that means every indexed entry carries a second copy of the object
+ * name, key and namespace strings, plus a heap allocated node.
+ *
+ * The key of every index is a member of the indexed entry, so we only
+ * need to store the entry pointer: the key is read through it.  This
+ * is an open addressing table (linear probing, backward shift deletion)
+ * of such pointers, with an unordered_map compatible subset of the
+ * interface: find(), count(), erase(), size(), and iterators whose
+ * value exposes ->first (the key) and ->second (the entry).
+ *
+ * Every pointer stored must stay valid until it is erased or the index
+ * is cleared, since probing dereferences it.  IndexedLog already keeps
+ * this invariant: entries are unindexed before they are freed.
+ */
+template <typename T, typename Key, Key T::*key_member,
+	  typename Hash = std::hash<Key>>
+class PGLogIndex {
+  mempool::osd_pglog::vector<T*> slots;
+  size_t num = 0;
+  unsigned bits = 0;
+
+  static constexpr unsigned MIN_BITS = 4;
+
+  size_t slot_of(const Key& k) const {
+    // fibonacci hashing: std::hash<osd_reqid_t> and friends do no mixing
+    // of their own, and we select slots from the high bits.
+    return (uint64_t(Hash()(k)) * 0x9e3779b97f4a7c15ull) >> (64 - bits);
+  }
+  size_t mask() const {
+    return slots.size() - 1;
+  }
+
+  size_t find_slot(const Key& k) const {
+    if (num == 0) {
+      return slots.size();
+    }
+    for (size_t i = slot_of(k); ; i = (i + 1) & mask()) {
+      if (slots[i] == nullptr) {
+	return slots.size();
+      }
+      if (slots[i]->*key_member == k) {
+	return i;
+      }
+    }
+  }
+
+  void rehash(unsigned new_bits) {
+    mempool::osd_pglog::vector<T*> old(size_t(1) << new_bits, nullptr);
+    old.swap(slots);
+    bits = new_bits;
+    for (auto p : old) {
+      if (p) {
+	size_t i = slot_of(p->*key_member);
+	while (slots[i]) {
+	  i = (i + 1) & mask();
+	}
+	slots[i] = p;
+      }
+    }
+  }
+
+  void erase_slot(size_t i) {
+    ceph_assert(slots[i]);
+    slots[i] = nullptr;
+    --num;
+    // shift back later members of the cluster that would otherwise be
+    // unreachable from their home slot
+    for (size_t j = (i + 1) & mask(); slots[j]; j = (j + 1) & mask()) {
+      size_t home = slot_of(slots[j]->*key_member);
+      if (((j - home) & mask()) >= ((j - i) & mask())) {
+	slots[i] = slots[j];
+	slots[j] = nullptr;
+	i = j;
+      }
+    }
+  }
+
+public:
+  using key_type = Key;
+  using mapped_type = T*;
+
+  class iterator {
+    friend class PGLogIndex;
+    T* const *pos = nullptr;
+    T* const *last = nullptr;
+
+    iterator(T* const *pos, T* const *last) : pos(pos), last(last) {
+      skip();
+    }
+    void skip() {
+      while (pos != last && *pos == nullptr) {
+	++pos;
+      }
+    }
+  public:
+    struct reference {
+      const Key& first;
+      T* second;
+      const reference* operator->() const {
+	return this;
+      }
+    };
+
+    iterator() = default;
+    reference operator*() const {
+      return {(*pos)->*key_member, *pos};
+    }
+    reference operator->() const {
+      return **this;
+    }
+    iterator& operator++() {
+      ++pos;
+      skip();
+      return *this;
+    }
+    bool operator==(const iterator& rhs) const {
+      return pos == rhs.pos;
+    }
+    bool operator!=(const iterator& rhs) const {
+      return pos != rhs.pos;
+    }
+  };
+
+  iterator begin() const {
+    return iterator(slots.data(), slots.data() + slots.size());
+  }
+  iterator end() const {
+    return iterator(slots.data() + slots.size(), slots.data() + slots.size());
+  }
+
+  size_t size() const {
+    return num;
+  }
+  bool empty() const {
+    return num == 0;
+  }
+  /// size of the table itself; exposed for memory accounting in tests
+  size_t capacity() const {
+    return slots.size();
+  }
+
+  void reserve(size_t n) {
+    unsigned want = MIN_BITS;
+    while ((size_t(3) << want) / 4 < n) {
+      ++want;
+    }
+    if (want > bits) {
+      rehash(want);
+    }
+  }
+
+  /// drop all entries, keeping the table for the next index pass
+  void clear() {
+    std::fill(slots.begin(), slots.end(), nullptr);
+    num = 0;
+  }
+
+  iterator find(const Key& k) const {
+    return iterator(slots.data() + find_slot(k),
+		    slots.data() + slots.size());
+  }
+  size_t count(const Key& k) const {
+    return find_slot(k) != slots.size();
+  }
+
+  /// index e under its key, replacing any entry with the same key
+  void insert_or_assign(T* e) {
+    ceph_assert(e);
+    reserve(num + 1);
+    size_t i = slot_of(e->*key_member);
+    for (; slots[i]; i = (i + 1) & mask()) {
+      if (slots[i]->*key_member == e->*key_member) {
+	slots[i] = e;
+	return;
+      }
+    }
+    slots[i] = e;
+    ++num;
+  }
+
+  void erase(iterator it) {
+    erase_slot(it.pos - slots.data());
+  }
+  size_t erase(const Key& k) {
+    size_t i = find_slot(k);
+    if (i == slots.size()) {
+      return 0;
+    }
+    erase_slot(i);
+    return 1;
+  }
+};
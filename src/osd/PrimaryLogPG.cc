@@ -4499,7 +4499,31 @@ void PrimaryLogPG::do_scan(
       // Check that from is in backfill_targets vector
       ceph_assert(is_backfill_target(from));
 
+      if (auto pf = peer_backfill_prefetching.find(from);
+	  pf != peer_backfill_prefetching.end() && pf->second == m->begin) {
+	peer_backfill_prefetching.erase(pf);
+	if (!waiting_on_backfill.count(from)) {
+	  // keep it until recover_backfill() is through the current interval
+	  BackfillInterval& next = peer_backfill_prefetch[from];
+	  next.begin = m->begin;
+	  next.end = m->end;
+	  auto p = m->get_data().cbegin();
+	  next.clear_objects();
+	  decode_noclear(next.objects, p);
+	  dout(10) << __func__ << " prefetched next.begin=" << next.begin
+		   << " next.end=" << next.end
+		   << " next.objects.size()=" << next.objects.size() << dendl;
+	  break;
+	}
+	// recover_backfill() is already waiting for it
+      }
+
       BackfillInterval& bi = peer_backfill_info[from];
+      if (waiting_on_backfill.count(from) && m->begin != bi.end) {
+	dout(10) << __func__ << " ignoring stale scan from " << m->begin
+		 << ", waiting for " << bi.end << dendl;
+	break;
+      }
       bi.begin = m->begin;
       bi.end = m->end;
       auto p = m->get_data().cbegin();
@@ -13889,6 +13913,8 @@ uint64_t PrimaryLogPG::recover_backfill(
 	recovery_state.get_peer_info(*i).last_backfill);
     }
     backfill_info.reset(last_backfill_started);
+    peer_backfill_prefetch.clear();
+    peer_backfill_prefetching.clear();
 
     backfills_in_flight.clear();
     pending_backfill_updates.clear();
@@ -13937,6 +13963,8 @@ uint64_t PrimaryLogPG::recover_backfill(
     dout(20) << "   my backfill interval " << backfill_info << dendl;
 
     bool sent_scan = false;
+    const bool prefetch =
+      cct->_conf.get_val<bool>("osd_backfill_scan_prefetch");
     for (set<pg_shard_t>::const_iterator i = get_backfill_targets().begin();
 	 i != get_backfill_targets().end();
 	 ++i) {
@@ -13946,22 +13974,44 @@ uint64_t PrimaryLogPG::recover_backfill(
       dout(20) << " peer shard " << bt << " backfill " << pbi << dendl;
       if (pbi.begin <= backfill_info.begin &&
 	  !pbi.extends_to_end() && pbi.empty()) {
-	dout(10) << " scanning peer osd." << bt << " from " << pbi.end << dendl;
-	epoch_t e = get_osdmap_epoch();
-	MOSDPGScan *m = new MOSDPGScan(
-	  MOSDPGScan::OP_SCAN_GET_DIGEST, pg_whoami, e, get_last_peering_reset(),
-	  spg_t(info.pgid.pgid, bt.shard),
-	  pbi.end, hobject_t());
-
-	if (cct->_conf->osd_op_queue == "mclock_scheduler") {
-	  /* This guard preserves legacy WeightedPriorityQueue behavior for
-	   * now, but should be removed after Reef */
-	  m->set_priority(recovery_state.get_recovery_op_priority());
+	if (auto p = peer_backfill_prefetch.find(bt);
+	    p != peer_backfill_prefetch.end()) {
+	  bool usable = p->second.begin == pbi.end;
+	  if (usable) {
+	    dout(10) << " using prefetched scan of peer osd." << bt
+		     << " " << p->second << dendl;
+	    pbi = std::move(p->second);
+	  }
+	  peer_backfill_prefetch.erase(p);
+	  if (usable) {
+	    continue;
+	  }
 	}
-	osd->send_message_osd_cluster(bt.osd, m, get_osdmap_epoch());
 	ceph_assert(waiting_on_backfill.find(bt) == waiting_on_backfill.end());
+	if (auto pf = peer_backfill_prefetching.find(bt);
+	    pf != peer_backfill_prefetching.end()) {
+	  if (pf->second == pbi.end) {
+	    dout(10) << " waiting on prefetch scan of peer osd." << bt
+		     << " from " << pbi.end << dendl;
+	    waiting_on_backfill.insert(bt);
+	    sent_scan = true;
+	    continue;
+	  }
+	  // do_scan() ignores the reply to a stale prefetch
+	  peer_backfill_prefetching.erase(pf);
+	}
+	dout(10) << " scanning peer osd." << bt << " from " << pbi.end << dendl;
+	send_backfill_scan(bt, pbi.end);
 	waiting_on_backfill.insert(bt);
         sent_scan = true;
+      } else if (prefetch && !pbi.extends_to_end() &&
+		 !peer_backfill_prefetch.count(bt) &&
+		 !peer_backfill_prefetching.count(bt)) {
+	// scan the next interval of the peer while we work through this one
+	dout(10) << " prefetching scan of peer osd." << bt
+		 << " from " << pbi.end << dendl;
+	send_backfill_scan(bt, pbi.end);
+	peer_backfill_prefetching[bt] = pbi.end;
       }
     }
 
@@ -14263,6 +14313,22 @@ int PrimaryLogPG::prep_backfill_object_push(
   return r;
 }
 
+void PrimaryLogPG::send_backfill_scan(pg_shard_t bt, const hobject_t &begin)
+{
+  epoch_t e = get_osdmap_epoch();
+  MOSDPGScan *m = new MOSDPGScan(
+    MOSDPGScan::OP_SCAN_GET_DIGEST, pg_whoami, e, get_last_peering_reset(),
+    spg_t(info.pgid.pgid, bt.shard),
+    begin, hobject_t());
+
+  if (cct->_conf->osd_op_queue == "mclock_scheduler") {
+    /* This guard preserves legacy WeightedPriorityQueue behavior for
+     * now, but should be removed after Reef */
+    m->set_priority(recovery_state.get_recovery_op_priority());
+  }
+  osd->send_message_osd_cluster(bt.osd, m, get_osdmap_epoch());
+}
+
 void PrimaryLogPG::update_range(
   BackfillInterval *bi,
   ThreadPool::TPHandle &handle)
@@ -14533,7 +14599,7 @@ void PrimaryLogPG::hit_set_create()
   HitSet::Params params(pool.info.hit_set_params);
 
   dout(20) << __func__ << " " << params << dendl;
-  if (pool.info.hit_set_params.get_type() == HitSet::TYPE_BLOOM) {
+  if (HitSet::is_bloom_type(pool.info.hit_set_params.get_type())) {
     BloomHitSet::Params *p =
       static_cast<BloomHitSet::Params*>(params.impl.get());
 
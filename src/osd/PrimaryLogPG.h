@@ -703,6 +703,38 @@ public:
     int num_read;    ///< count read ops
     int num_write;   ///< count update ops
 
+    /**
+     * omap and xattr values read by object class methods
+     *
+     * Reads within an op see the object as it was before the op, so
+     * repeated lookups of the same key by cls methods can be served from
+     * here.  The op's own updates may however change what a read returns
+     * (e.g. after a delete or omap clear), so everything is dropped once
+     * the op issued a write.
+     */
+    struct cls_read_cache_t {
+      int num_write = 0;
+      std::optional<ceph::buffer::list> omap_header;
+      /// omap key -> value, nullopt if the key does not exist
+      std::map<std::string, std::optional<ceph::buffer::list>, std::less<>> omap;
+      /// xattr name -> value, nullopt if the xattr does not exist
+      std::map<std::string, std::optional<ceph::buffer::list>, std::less<>> xattrs;
+
+      void clear() {
+	omap_header.reset();
+	omap.clear();
+	xattrs.clear();
+      }
+    } cls_read_cache;
+
+    cls_read_cache_t& get_cls_read_cache() {
+      if (cls_read_cache.num_write != num_write) {
+	cls_read_cache.clear();
+	cls_read_cache.num_write = num_write;
+      }
+      return cls_read_cache;
+    }
+
     mempool::osd_pglog::vector<std::pair<osd_reqid_t, version_t> > extra_reqids;
     mempool::osd_pglog::map<uint32_t, int> extra_reqid_return_codes;
 
@@ -786,6 +818,7 @@ public:
       inflightreads(0),
       lock_type(RWState::RWNONE) {}
     void reset_obs(ObjectContextRef obc) {
+      cls_read_cache.clear();
       new_obs = ObjectState(obc->obs.oi, obc->obs.exists);
       if (obc->ssc) {
 	new_snapset = obc->ssc->snapset;
@@ -1117,6 +1150,16 @@ protected:
       }
       f->close_section();
     }
+    {
+      f->open_array_section("peer_backfill_prefetching");
+      for (const auto& [peer, begin] : peer_backfill_prefetching) {
+	f->open_object_section("prefetch");
+	f->dump_stream("osd") << peer;
+	f->dump_stream("begin") << begin;
+	f->close_section();
+      }
+      f->close_section();
+    }
     {
       f->open_array_section("backfills_in_flight");
       for (std::set<hobject_t>::const_iterator i = backfills_in_flight.begin();
@@ -1287,6 +1330,8 @@ protected:
    */
   uint64_t recover_backfill(uint64_t max, ThreadPool::TPHandle &handle,
 			    bool *work_started);
+  /// ask backfill target bt for a digest of its objects from begin on
+  void send_backfill_scan(pg_shard_t bt, const hobject_t &begin);
 
   /**
    * scan a (hash) range of objects in the current pg
@@ -561,7 +561,7 @@ void ReplicatedBackend::op_commit(const ceph::ref_t<InProgressOp>& op)
   OID_EVENT_TRACE_WITH_MSG((op && op->op) ? op->op->get_req() : NULL, "OP_COMMIT_BEGIN", true);
   dout(10) << __func__ << ": " << op->tid << dendl;
   if (op->op) {
-    op->op->mark_event("op_commit");
+    op->op->mark_event(op_stage_t::op_commit);
     op->op->pg_trace.event("op commit");
   }
 
@@ -610,7 +610,7 @@ void ReplicatedBackend::do_repop_reply(OpRequestRef op)
       ceph_assert(ip_op.waiting_for_commit.count(from));
       ip_op.waiting_for_commit.erase(from);
       if (ip_op.op) {
-	ip_op.op->mark_event("sub_op_commit_rec");
+	ip_op.op->mark_event(op_stage_t::sub_op_commit_rec);
 	ip_op.op->pg_trace.event("sub_op_commit_rec");
       }
     } else {
@@ -657,13 +657,15 @@ int ReplicatedBackend::be_deep_scrub(
 
     const uint64_t stride = cct->_conf->osd_deep_scrub_stride;
 
-    bufferlist bl;
-    r = store->read(
+    // let the store hash the data: it may be able to reuse the
+    // checksums it verifies on read rather than hand us the data
+    uint32_t crc = pos.data_hash.digest();
+    r = store->read_crc32c(
       ch,
       ghobject_t(
 	poid, ghobject_t::NO_GEN, get_parent()->whoami_shard().shard),
       pos.data_pos,
-      stride, bl,
+      stride, &crc,
       fadvise_flags);
     if (r < 0) {
       dout(20) << __func__ << "  " << poid << " got "
@@ -672,7 +674,7 @@ int ReplicatedBackend::be_deep_scrub(
       return 0;
     }
     if (r > 0) {
-      pos.data_hash << bl;
+      pos.data_hash = bufferhash(crc);
     }
     pos.data_pos += r;
     if (static_cast<uint64_t>(r) == stride) {
@@ -1600,6 +1602,7 @@ int ReplicatedBackend::prep_push(
   if (r < 0)
     return r;
   push_info.recovery_progress = new_progress;
+  push_info.chunks_in_flight = 1;
   return 0;
 }
 
@@ -2221,6 +2224,8 @@ bool ReplicatedBackend::handle_push_reply(
     return false;
   } else {
     push_info_t *push_info = &pushing[soid][peer];
+    if (push_info->chunks_in_flight > 0)
+      --push_info->chunks_in_flight;
     bool error = pushing[soid].begin()->second.recovery_progress.error;
 
     if (!push_info->recovery_progress.data_complete && !error) {
@@ -2238,10 +2243,21 @@ bool ReplicatedBackend::handle_push_reply(
         dout(5) << __func__ << ": oid " << soid << " error " << r << dendl;
 
 	error = true;
+	if (push_info->chunks_in_flight > 0) {
+	  // let the chunks already sent land before giving up on soid
+	  pushing[soid].begin()->second.recovery_progress.error = true;
+	  return false;
+	}
 	goto done;
       }
       push_info->recovery_progress = new_progress;
+      ++push_info->chunks_in_flight;
       return true;
+    } else if (push_info->chunks_in_flight > 0) {
+      dout(10) << "pushed " << soid << " to osd." << peer
+	       << ", still waiting for " << push_info->chunks_in_flight
+	       << " chunk acks" << dendl;
+      return false;
     } else {
       // done!
 done:
@@ -2428,5 +2444,44 @@ int ReplicatedBackend::start_pushes(
       return r;
     }
   }
+  for (auto j : shards) {
+    fill_push_pipeline(soid, j->first, &(h->pushes[j->first]));
+  }
   return shards.size();
 }
+
+void ReplicatedBackend::fill_push_pipeline(
+  const hobject_t &soid,
+  pg_shard_t peer,
+  vector<PushOp> *pops)
+{
+  // Large objects are pushed in osd_recovery_max_chunk sized chunks.
+  // Rather than waiting for the ack of each chunk before reading the
+  // next, keep up to osd_recovery_push_pipeline_depth of them in flight.
+  // The peer applies them in order since they share the connection and
+  // the pg queue; handle_push_reply() refills the pipeline on every ack.
+  const auto depth =
+    cct->_conf.get_val<uint64_t>("osd_recovery_push_pipeline_depth");
+  push_info_t &push_info = pushing[soid][peer];
+  while (!push_info.recovery_progress.data_complete &&
+	 push_info.chunks_in_flight < depth) {
+    dout(10) << __func__ << " " << soid << " to osd." << peer
+	     << " from " << push_info.recovery_progress.data_recovered_to
+	     << ", " << push_info.chunks_in_flight << " in flight" << dendl;
+    ObjectRecoveryProgress new_progress;
+    pops->push_back(PushOp());
+    int r = build_push_op(
+      push_info.recovery_info,
+      push_info.recovery_progress, &new_progress, &pops->back(),
+      &push_info.stat);
+    if (r < 0) {
+      dout(5) << __func__ << ": oid " << soid << " error " << r << dendl;
+      pops->pop_back();
+      // fail soid once the chunks in flight are acked
+      pushing[soid].begin()->second.recovery_progress.error = true;
+      break;
+    }
+    push_info.recovery_progress = new_progress;
+    ++push_info.chunks_in_flight;
+  }
+}
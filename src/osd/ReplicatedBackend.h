@@ -24,6 +24,7 @@ class ReplicatedBackend : public PGBackend {
     std::map<pg_shard_t, std::vector<PullOp> > pulls;
   };
   friend struct C_ReplicatedBackend_OnPullComplete;
+  friend class ReplicatedBackendTest;
 public:
   ReplicatedBackend(
     PGBackend::Listener *pg,
@@ -161,6 +162,8 @@ private:
     ObjectContextRef obc;
     object_stat_sum_t stat;
     ObcLockManager lock_manager;
+    /// chunks sent to the peer and not acked yet
+    unsigned chunks_in_flight = 0;
 
     void dump(ceph::Formatter *f) const {
       {
@@ -173,6 +176,7 @@ private:
 	recovery_info.dump(f);
 	f->close_section();
       }
+      f->dump_unsigned("chunks_in_flight", chunks_in_flight);
     }
   };
   std::map<hobject_t, std::map<pg_shard_t, push_info_t>> pushing;
@@ -292,6 +296,10 @@ private:
     const hobject_t &soid,
     ObjectContextRef obj,
     RPGHandle *h);
+  void fill_push_pipeline(
+    const hobject_t &soid,
+    pg_shard_t peer,
+    std::vector<PushOp> *pops);
   int prep_push_to_replica(
     ObjectContextRef obc, const hobject_t& soid, pg_shard_t peer,
     PushOp *pop, bool cache_dont_need = true);
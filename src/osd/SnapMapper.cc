@@ -184,6 +184,25 @@ int OSDriver::get_next(
   }
 }
 
+int OSDriver::get_next_n(
+  const std::string &key,
+  unsigned max,
+  std::vector<std::pair<std::string, ceph::buffer::list>> *next)
+{
+  ObjectMap::ObjectMapIterator iter =
+    os->get_omap_iterator(ch, hoid);
+  if (!iter) {
+    ceph_abort();
+    return -EINVAL;
+  }
+  for (iter->upper_bound(key);
+       iter->valid() && next->size() < max;
+       iter->next()) {
+    next->emplace_back(iter->key(), iter->value());
+  }
+  return next->empty() ? -ENOENT : 0;
+}
+
 int OSDriver::get_next_or_current(
   const std::string &key,
   std::pair<std::string, ceph::buffer::list> *next_or_current)
@@ -586,34 +605,36 @@ vector<hobject_t> SnapMapper::get_objects_by_prefixes(
   for ( ; prefix_itr != prefixes.end(); prefix_itr++) {
     const string prefix(get_prefix(pool, snap) + *prefix_itr);
     string pos = prefix;
-    while (out.size() < max) {
-      pair<string, ceph::buffer::list> next;
-      // access RocksDB (an expensive operation!)
-      int r = backend.get_next(pos, &next);
-      dout(20) << __func__ << " get_next(" << pos << ") returns " << r
-	       << " " << next.first << dendl;
+    bool prefix_done = false;
+    while (!prefix_done && out.size() < max) {
+      // access RocksDB (an expensive operation!): fetch all the keys we
+      // still want through one iterator rather than seeking once per key
+      vector<pair<string, ceph::buffer::list>> next;
+      int r = backend.get_next_n(pos, max - out.size(), &next);
+      dout(20) << __func__ << " get_next_n(" << pos << ") returns " << r
+	       << " " << next.size() << " keys" << dendl;
       if (r != 0) {
 	return out; // Done
       }
 
-      ceph_assert(is_mapping(next.first));
-
-      if (auto next_prefix = next.first.substr(0, prefix.size());
-          next_prefix != prefix) {
-	// TBD: we access the DB twice for the first object of each iterator...
-	dout(20) << fmt::format("{}: breaking, prefix expected {} got {}",
-	                        __func__, prefix, next_prefix)
-	         << dendl;
-	break; // Done with this prefix
-      }
+      for (auto& kv : next) {
+	if (kv.first.compare(0, prefix.size(), prefix) != 0) {
+	  dout(20) << fmt::format("{}: breaking, prefix expected {} got {}",
+				  __func__, prefix, kv.first)
+		   << dendl;
+	  prefix_done = true;
+	  break; // Done with this prefix
+	}
+	ceph_assert(is_mapping(kv.first));
 
-      dout(20) << __func__ << " " << next.first << dendl;
-      pair<snapid_t, hobject_t> next_decoded(from_raw(next));
-      ceph_assert(next_decoded.first == snap);
-      ceph_assert(check(next_decoded.second));
+	dout(20) << __func__ << " " << kv.first << dendl;
+	pair<snapid_t, hobject_t> next_decoded(from_raw(kv));
+	ceph_assert(next_decoded.first == snap);
+	ceph_assert(check(next_decoded.second));
 
-      out.push_back(next_decoded.second);
-      pos = next.first;
+	out.push_back(next_decoded.second);
+      }
+      pos = next.back().first;
     }
 
     if (out.size() >= max) {
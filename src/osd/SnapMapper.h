@@ -92,6 +92,12 @@ public:
   int get_next(
     const std::string &key,
     std::pair<std::string, ceph::buffer::list> *next) override;
+#ifndef WITH_SEASTAR
+  int get_next_n(
+    const std::string &key,
+    unsigned max,
+    std::vector<std::pair<std::string, ceph::buffer::list>> *next) override;
+#endif
   int get_next_or_current(
     const std::string &key,
     std::pair<std::string, ceph::buffer::list> *next_or_current) override;
@@ -30,6 +30,21 @@ using ceph::real_time;
 
 static constexpr int dout_subsys = ceph_subsys_objclass;
 
+// a read served from the cls read cache is accounted like the op it saved,
+// len being the size of the op's outdata
+static void account_cached_read(PrimaryLogPG::OpContext *ctx, uint64_t len)
+{
+  ++ctx->num_read;
+  ctx->delta_stats.num_rd++;
+  ctx->delta_stats.num_rd_kb += shift_round_up(len, 10);
+}
+
+// size of an encoded omap key/value pair, as returned by OMAPGETVALSBYKEYS
+static uint64_t encoded_omap_entry_len(const string& key, const bufferlist& val)
+{
+  return sizeof(uint32_t) + key.size() + sizeof(uint32_t) + val.length();
+}
+
 
 int cls_call(cls_method_context_t hctx, const char *cls, const char *method,
 	     char *indata, int datalen, char **outdata, int *outdatalen)
@@ -276,6 +291,17 @@ int cls_cxx_getxattr(cls_method_context_t hctx, const char *name,
                      bufferlist *outbl)
 {
   PrimaryLogPG::OpContext **pctx = (PrimaryLogPG::OpContext **)hctx;
+  auto& cache = (*pctx)->get_cls_read_cache();
+  if (auto p = cache.xattrs.find(name); p != cache.xattrs.end()) {
+    if (!p->second) {
+      account_cached_read(*pctx, 0);
+      return -ENODATA;
+    }
+    account_cached_read(*pctx, p->second->length());
+    *outbl = *p->second;
+    return outbl->length();
+  }
+
   vector<OSDOp> nops(1);
   OSDOp& op = nops[0];
   int r;
@@ -284,10 +310,14 @@ int cls_cxx_getxattr(cls_method_context_t hctx, const char *name,
   op.op.xattr.name_len = strlen(name);
   op.indata.append(name, op.op.xattr.name_len);
   r = (*pctx)->pg->do_osd_ops(*pctx, nops);
+  if (r == -ENODATA) {
+    cache.xattrs.emplace(name, std::nullopt);
+  }
   if (r < 0)
     return r;
 
   *outbl = std::move(op.outdata);
+  cache.xattrs.emplace(name, *outbl);
   return outbl->length();
 }
 
@@ -431,6 +461,13 @@ int cls_cxx_map_get_vals(cls_method_context_t hctx, const string &start_obj,
 int cls_cxx_map_read_header(cls_method_context_t hctx, bufferlist *outbl)
 {
   PrimaryLogPG::OpContext **pctx = (PrimaryLogPG::OpContext **)hctx;
+  auto& cache = (*pctx)->get_cls_read_cache();
+  if (cache.omap_header) {
+    account_cached_read(*pctx, cache.omap_header->length());
+    *outbl = *cache.omap_header;
+    return 0;
+  }
+
   vector<OSDOp> ops(1);
   OSDOp& op = ops[0];
   int ret;
@@ -440,6 +477,7 @@ int cls_cxx_map_read_header(cls_method_context_t hctx, bufferlist *outbl)
     return ret;
 
   *outbl = std::move(op.outdata);
+  cache.omap_header = *outbl;
 
   return 0;
 }
@@ -448,6 +486,18 @@ int cls_cxx_map_get_val(cls_method_context_t hctx, const string &key,
 			bufferlist *outbl)
 {
   PrimaryLogPG::OpContext **pctx = (PrimaryLogPG::OpContext **)hctx;
+  auto& cache = (*pctx)->get_cls_read_cache();
+  if (auto p = cache.omap.find(key); p != cache.omap.end()) {
+    if (!p->second) {
+      account_cached_read(*pctx, sizeof(uint32_t));
+      return -ENOENT;
+    }
+    account_cached_read(*pctx, sizeof(uint32_t) +
+			encoded_omap_entry_len(key, *p->second));
+    *outbl = *p->second;
+    return 0;
+  }
+
   vector<OSDOp> ops(1);
   OSDOp& op = ops[0];
   int ret;
@@ -467,10 +517,13 @@ int cls_cxx_map_get_val(cls_method_context_t hctx, const string &key,
 
     decode(m, iter);
     map<string, bufferlist>::iterator iter = m.begin();
-    if (iter == m.end())
+    if (iter == m.end()) {
+      cache.omap.emplace(key, std::nullopt);
       return -ENOENT;
+    }
 
     *outbl = iter->second;
+    cache.omap.emplace(key, iter->second);
   } catch (ceph::buffer::error& e) {
     return -EIO;
   }
@@ -482,11 +535,30 @@ int cls_cxx_map_get_vals_by_keys(cls_method_context_t hctx,
                                  std::map<std::string, bufferlist> *map)
 {
   PrimaryLogPG::OpContext **pctx = (PrimaryLogPG::OpContext **)hctx;
+  auto& cache = (*pctx)->get_cls_read_cache();
+  std::set<std::string> to_get;
+  uint64_t cached_len = 0;
+  map->clear();
+  for (const auto& key : keys) {
+    if (auto p = cache.omap.find(key); p == cache.omap.end()) {
+      to_get.insert(key);
+    } else if (p->second) {
+      map->emplace(key, *p->second);
+      cached_len += encoded_omap_entry_len(key, *p->second);
+    }
+  }
+  if (to_get.empty()) {
+    account_cached_read(*pctx, sizeof(uint32_t) + cached_len);
+    return 0;
+  }
+  // the read below is accounted for the keys it fetches, add the rest
+  (*pctx)->delta_stats.num_rd_kb += shift_round_up(cached_len, 10);
+
   vector<OSDOp> ops(1);
   OSDOp& op = ops[0];
   int ret;
 
-  encode(keys, op.indata);
+  encode(to_get, op.indata);
 
   op.op.op = CEPH_OSD_OP_OMAPGETVALSBYKEYS;
   ret = (*pctx)->pg->do_osd_ops(*pctx, ops);
@@ -494,11 +566,21 @@ int cls_cxx_map_get_vals_by_keys(cls_method_context_t hctx,
     return ret;
 
   auto iter = op.outdata.cbegin();
+  std::map<std::string, bufferlist> got;
   try {
-    decode(*map, iter);
+    decode(got, iter);
   } catch (buffer::error& e) {
     return -EIO;
   }
+  for (const auto& key : to_get) {
+    auto p = got.find(key);
+    if (p == got.end()) {
+      cache.omap.emplace(key, std::nullopt);
+    } else {
+      cache.omap.emplace(key, p->second);
+    }
+  }
+  map->merge(got);
   return 0;
 }
 
@@ -133,6 +133,28 @@ PerfCounters *build_osd_logger(CephContext *cct) {
   osd_plb.add_time_avg(l_osd_op_before_dequeue_op_lat, "op_before_dequeue_op_lat",
     "Latency of IO before calling dequeue_op(already dequeued and get PG lock)"); // client io before dequeue_op latency
 
+  osd_plb.add_u64_counter(
+    l_osd_op_wq_steal, "op_wq_steal",
+    "Op queue items processed by a thread of another shard");
+  PerfHistogramCommon::axis_config_d op_wq_depth_x_axis_config{
+    "Queue depth",
+    PerfHistogramCommon::SCALE_LOG2, ///< Depth in logarithmic scale
+    0,                               ///< Start at 0
+    1,                               ///< Quantization unit is 1 item
+    16,                              ///< Up to tens of thousands of items
+  };
+  PerfHistogramCommon::axis_config_d op_wq_depth_y_axis_config{
+    "Shard",
+    PerfHistogramCommon::SCALE_LINEAR,
+    0,                               ///< Start at shard 0
+    1,                               ///< One bucket per shard
+    32,                              ///< Larger shard ids share the last one
+  };
+  osd_plb.add_u64_counter_histogram(
+    l_osd_op_wq_depth_hist, "op_wq_depth_histogram",
+    op_wq_depth_x_axis_config, op_wq_depth_y_axis_config,
+    "Histogram of op queue depth seen at enqueue, per shard");
+
   osd_plb.add_u64_counter(
     l_osd_sop, "subop", "Suboperations");
   osd_plb.add_u64_counter(
@@ -338,6 +360,23 @@ PerfCounters *build_osd_logger(CephContext *cct) {
       l_osd_scrub_reservation_dur_hist, "scrub_resrv_repnum_vs_duration",
       rsrv_hist_x_axis_config, rsrv_hist_y_axis_config, "Histogram of scrub replicas reservation duration");
 
+  // updated for every client op, by all the op shard threads at once
+  for (int idx : {
+	 l_osd_op, l_osd_op_inb, l_osd_op_outb,
+	 l_osd_op_lat, l_osd_op_process_lat, l_osd_op_prepare_lat,
+	 l_osd_op_r, l_osd_op_r_outb,
+	 l_osd_op_r_lat, l_osd_op_r_process_lat, l_osd_op_r_prepare_lat,
+	 l_osd_op_r_lat_outb_hist,
+	 l_osd_op_w, l_osd_op_w_inb,
+	 l_osd_op_w_lat, l_osd_op_w_process_lat, l_osd_op_w_prepare_lat,
+	 l_osd_op_w_lat_inb_hist,
+	 l_osd_op_rw, l_osd_op_rw_inb, l_osd_op_rw_outb,
+	 l_osd_op_rw_lat, l_osd_op_rw_process_lat, l_osd_op_rw_prepare_lat,
+	 l_osd_op_rw_lat_inb_hist, l_osd_op_rw_lat_outb_hist,
+	 l_osd_op_before_queue_op_lat, l_osd_op_before_dequeue_op_lat}) {
+    osd_plb.set_sharded(idx);
+  }
+
   return osd_plb.create_perf_counters();
 }
 
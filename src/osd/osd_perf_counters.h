@@ -43,6 +43,9 @@ enum {
   l_osd_op_before_queue_op_lat,
   l_osd_op_before_dequeue_op_lat,
 
+  l_osd_op_wq_steal,
+  l_osd_op_wq_depth_hist,
+
   l_osd_sop,
   l_osd_sop_inb,
   l_osd_sop_lat,
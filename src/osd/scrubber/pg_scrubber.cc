@@ -1355,6 +1355,12 @@ int PgScrubber::build_scrub_map_chunk(ScrubMap& map,
       break;
     }
     m_pg->_scan_rollback_obs(rollback_obs);
+    // the map is keyed by object, so the scan order is ours to pick: read
+    // the chunk in device order rather than in hash order
+    if (deep &&
+	get_pg_cct()->_conf.get_val<bool>("osd_deep_scrub_device_order")) {
+      m_pg->get_pgbackend()->be_sort_by_device_offset(pos.ls);
+    }
     pos.pos = 0;
     return -EINPROGRESS;
   }
@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+#
+# Compare osd_op_queue_work_stealing off and on under a skewed PG load.
+#
+# A "hot" pool with a single PG is hammered by one rados bench while a
+# "cold" pool with many PGs sees a light load.  With a single OSD all PGs
+# live on osd.0: the hot PG backs up the queue of its OSDShard, and cold
+# ops that hash to the same shard queue up behind it.  Work stealing lets
+# the idle threads of the other shards take those over, so the cold pool
+# latency is the figure to look at; the hot pool itself cannot go faster
+# since ops of one PG still run in order.
+#
+# Run from the build directory; starts and stops a vstart cluster for
+# each setting.
+
+set -e
+
+usage() {
+    cat <<EOF
+usage: $(basename $0) [options]
+
+options:
+  -d,--duration      seconds each rados bench runs, default 60
+  -s,--shards        osd_op_num_shards, default 4
+  --hot-threads      concurrent ops against the hot pool, default 64
+  --cold-threads     concurrent ops against the cold pool, default 4
+  --cold-pgs         number of PGs of the cold pool, default 32
+  -b,--block-size    object size, default 4096
+  -h,--help          print this help message
+EOF
+}
+
+duration=60
+shards=4
+hot_threads=64
+cold_threads=4
+cold_pgs=32
+block_size=4096
+
+opts=$(getopt --options "d:s:b:h" --longoptions "duration:,shards:,hot-threads:,cold-threads:,cold-pgs:,block-size:,help" --name $(basename $0) -- "$@")
+eval set -- "$opts"
+
+while true; do
+    case "$1" in
+        -d|--duration)
+            duration=$2
+            shift 2
+            ;;
+        -s|--shards)
+            shards=$2
+            shift 2
+            ;;
+        --hot-threads)
+            hot_threads=$2
+            shift 2
+            ;;
+        --cold-threads)
+            cold_threads=$2
+            shift 2
+            ;;
+        --cold-pgs)
+            cold_pgs=$2
+            shift 2
+            ;;
+        -b|--block-size)
+            block_size=$2
+            shift 2
+            ;;
+        -h|--help)
+            usage
+            exit 0
+            ;;
+        --)
+            shift
+            break
+            ;;
+        *)
+            echo "unexpected argument $1" 1>&2
+            usage
+            exit 1
+            ;;
+    esac
+done
+
+if [ ! -e CMakeCache.txt ] || [ ! -x bin/ceph-osd ]; then
+    echo "$(basename $0) must be run from the build directory" 1>&2
+    exit 1
+fi
+
+out_dir=$(mktemp -d bench_op_wq_stealing.XXXXXX)
+
+for steal in false true; do
+    MON=1 OSD=1 MDS=0 MGR=1 RGW=0 ../src/vstart.sh -n -x -l --without-dashboard \
+        -o "osd_op_queue_work_stealing = $steal" \
+        -o "osd_op_num_shards = $shards" \
+        -o "osd_pool_default_pg_autoscale_mode = off" \
+        > $out_dir/vstart.$steal 2>&1
+
+    bin/ceph osd pool create hot 1 1
+    bin/ceph osd pool create cold $cold_pgs $cold_pgs
+    bin/ceph osd pool set hot size 1 --yes-i-really-mean-it
+    bin/ceph osd pool set cold size 1 --yes-i-really-mean-it
+    bin/ceph osd pool application enable hot rados
+    bin/ceph osd pool application enable cold rados
+    bin/ceph tell osd.0 perf reset osd
+
+    bin/rados -p hot bench $duration write -t $hot_threads -b $block_size \
+        --run-name hot > $out_dir/hot.$steal &
+    hot_pid=$!
+    bin/rados -p cold bench $duration write -t $cold_threads -b $block_size \
+        --run-name cold > $out_dir/cold.$steal
+    wait $hot_pid
+
+    bin/ceph tell osd.0 perf dump osd > $out_dir/perf.$steal
+    ../src/stop.sh
+done
+
+for steal in false true; do
+    echo "osd_op_queue_work_stealing = $steal"
+    for pool in hot cold; do
+        echo "  $pool:"
+        grep -E "^(Bandwidth \(MB/sec\)|Average IOPS|Average Latency\(s\)|Max latency\(s\))" \
+            $out_dir/$pool.$steal | sed 's/^/    /'
+    done
+    echo "  op_wq_steal: $(grep -o '"op_wq_steal": [0-9]*' $out_dir/perf.$steal | cut -d' ' -f2)"
+done
+echo "raw output is in $out_dir"
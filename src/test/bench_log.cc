@@ -75,6 +75,8 @@ int main(int argc, const char **argv)
   utime_t t = ceph_clock_now();
   t -= start;
   cout << " flushing.. " << t << " so far ..." << std::endl;
+  cout << " submitted " << (uint64_t)((double)threads * num / (double)t)
+       << " lines/sec" << std::endl;
 
   g_ceph_context->_log->flush();
 
@@ -22,6 +22,7 @@
 #include <limits.h>
 #include <errno.h>
 #include <sys/uio.h>
+#include <thread>
 
 #include "include/buffer.h"
 #include "include/buffer_raw.h"
@@ -145,6 +146,81 @@ TEST(Buffer, BenchAlloc) {
   bench_buffer_alloc(4, 1000000);
 }
 
+void bench_buffer_alloc_remote_free(int size, int num)
+{
+  // allocate here, free on another thread, as the messenger and the osd do
+  std::vector<bufferptr> ptrs(num);
+  utime_t start = ceph_clock_now();
+  for (int i=0; i<num; ++i) {
+    ptrs[i] = buffer::create(size);
+  }
+  std::thread t([&ptrs] { ptrs.clear(); });
+  t.join();
+  for (int i=0; i<num; ++i) {
+    bufferptr p = buffer::create(size);
+  }
+  utime_t end = ceph_clock_now();
+  cout << num << " alloc of size " << size
+       << " freed remotely, then " << num << " local allocs"
+       << " in " << (end - start) << std::endl;
+}
+
+TEST(Buffer, BenchAllocRemoteFree) {
+  bench_buffer_alloc_remote_free(4000, 100000);
+  bench_buffer_alloc_remote_free(256, 100000);
+  bench_buffer_alloc_remote_free(32, 100000);
+}
+
+TEST(Buffer, PoolAcrossThreads) {
+  // buffers freed by other threads, including ones outliving the
+  // thread that allocated them, must stay intact and be reusable
+  std::vector<bufferlist> bls(8);
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < bls.size(); ++t) {
+    threads.emplace_back([&bls, t] {
+      for (unsigned i = 0; i < 1000; ++i) {
+	bufferlist bl;
+	bl.append(std::string(i % 5000 + 1, 'a' + t));
+	if (i % 2) {
+	  bls[t].claim_append(bl);
+	}
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (unsigned t = 0; t < bls.size(); ++t) {
+    std::string s = bls[t].to_str();
+    EXPECT_EQ(std::string::npos, s.find_first_not_of(char('a' + t)));
+    bls[t].clear();
+  }
+  for (unsigned i = 0; i < 1000; ++i) {
+    bufferptr p = buffer::create(i % 5000 + 1);
+    p.zero();
+  }
+}
+
+TEST(Buffer, PoolAccounting) {
+  if (get_env_bool("CEPH_BUFFER_NO_POOL")) {
+    GTEST_SKIP() << "buffer pooling is disabled";
+  }
+  // blocks a thread keeps for reuse are accounted in the buffer_cache
+  // mempool, and given back when the thread exits
+  auto& pool = mempool::get_pool(mempool::mempool_buffer_cache);
+  size_t before = pool.allocated_bytes();
+  std::thread t([&pool, before] {
+    for (unsigned i = 0; i < 1000; ++i) {
+      bufferptr p = buffer::create(i % 5000 + 1);
+    }
+    size_t cached = pool.allocated_bytes() - before;
+    EXPECT_LT(0u, cached);
+    EXPECT_GE(65536u, cached);
+  });
+  t.join();
+  EXPECT_EQ(before, pool.allocated_bytes());
+}
+
 TEST(BufferRaw, ostream) {
   bufferptr ptr(1);
   std::ostringstream stream;
@@ -14,6 +14,7 @@
 
 #include <iostream>
 #include <errno.h>
+#include <map>
 #include <string>
 
 #include "include/rados/librados.hpp"
@@ -281,3 +282,57 @@ TEST(ClsHello, Filter) {
   ASSERT_EQ(0, destroy_one_pool_pp(pool_name, cluster));
 }
 
+TEST(ClsHello, Reread) {
+  Rados cluster;
+  std::string pool_name = get_temp_pool_name();
+  ASSERT_EQ("", create_one_pool_pp(pool_name, cluster));
+  IoCtx ioctx;
+  cluster.ioctx_create(pool_name.c_str(), ioctx);
+
+  std::map<std::string, bufferlist> vals;
+  vals["a"].append("1");
+  vals["b"].append("2");
+  ASSERT_EQ(0, ioctx.omap_set("myobject", vals));
+  bufferlist xattr;
+  xattr.append("xv");
+  ASSERT_EQ(0, ioctx.setxattr("myobject", "x", xattr));
+
+  const std::string enoent = std::to_string(-ENOENT);
+  const std::string enodata = std::to_string(-ENODATA);
+  {
+    bufferlist in, out;
+    ASSERT_EQ(0, ioctx.exec("myobject", "hello", "reread", in, out));
+    std::map<std::string, std::string> seen;
+    auto p = out.cbegin();
+    decode(seen, p);
+    ASSERT_EQ(enoent, seen["missing"]);
+    ASSERT_EQ(enoent, seen["missing_again"]);
+    ASSERT_EQ(enodata, seen["xattr_missing"]);
+    ASSERT_EQ(enodata, seen["xattr_missing_again"]);
+    ASSERT_EQ("xv", seen["xattr"]);
+    ASSERT_EQ("xv", seen["xattr_again"]);
+    ASSERT_EQ("1", seen["a"]);
+    ASSERT_EQ("a=1;b=2;", seen["by_keys"]);
+    ASSERT_EQ("2", seen["b"]);
+  }
+  {
+    bufferlist in, out;
+    ASSERT_EQ(0, ioctx.exec("myobject", "hello", "reread_after_write", in, out));
+    std::map<std::string, std::string> seen;
+    auto p = out.cbegin();
+    decode(seen, p);
+    ASSERT_EQ("1", seen["a"]);
+    ASSERT_EQ("a=1;b=2;", seen["by_keys"]);
+    // reads see the omap as it was before the op ...
+    ASSERT_EQ("1", seen["a_after_set"]);
+    ASSERT_EQ("a=1;b=2;", seen["by_keys_after_remove"]);
+    // ... until it is cleared
+    ASSERT_EQ(enoent, seen["a_after_clear"]);
+    ASSERT_EQ("", seen["by_keys_after_clear"]);
+  }
+  std::map<std::string, bufferlist> after;
+  ASSERT_EQ(0, ioctx.omap_get_vals("myobject", "", 10, &after));
+  ASSERT_TRUE(after.empty());
+
+  ASSERT_EQ(0, destroy_one_pool_pp(pool_name, cluster));
+}
@@ -118,6 +118,59 @@ TEST(Histogram, Decay) {
   ASSERT_EQ(4u, h.h.size());
 }
 
+TEST(Histogram, Percentile) {
+  pow2_hist_t h;
+  ASSERT_EQ(0, h.get_percentile_upper_bound(50));
+
+  h.set_bin(0, 10);   // 0
+  h.set_bin(4, 80);   // 8..15
+  h.set_bin(10, 10);  // 512..1023
+  ASSERT_EQ(0, h.get_percentile_upper_bound(0));
+  ASSERT_EQ(0, h.get_percentile_upper_bound(10));
+  ASSERT_EQ(15, h.get_percentile_upper_bound(11));
+  ASSERT_EQ(15, h.get_percentile_upper_bound(50));
+  ASSERT_EQ(15, h.get_percentile_upper_bound(90));
+  ASSERT_EQ(1023, h.get_percentile_upper_bound(91));
+  ASSERT_EQ(1023, h.get_percentile_upper_bound(100));
+  ASSERT_EQ(1023, h.get_percentile_upper_bound(200));
+
+  h.add(1000);
+  ASSERT_EQ(1023, h.get_percentile_upper_bound(99));
+}
+
+TEST(Histogram, Fixed) {
+  pow2_hist_fixed_t h;
+  ASSERT_TRUE(h.empty());
+  ASSERT_EQ(0u, h.get_percentile_upper_bound(50));
+
+  for (int i = 0; i < 10; ++i)
+    h.add(0);
+  for (int i = 0; i < 80; ++i)
+    h.add(12);
+  for (int i = 0; i < 10; ++i)
+    h.add(1000);
+  ASSERT_FALSE(h.empty());
+  ASSERT_EQ(10u, h.h[0]);
+  ASSERT_EQ(80u, h.h[4]);
+  ASSERT_EQ(10u, h.h[10]);
+  ASSERT_EQ(0u, h.get_percentile_upper_bound(10));
+  ASSERT_EQ(15u, h.get_percentile_upper_bound(90));
+  ASSERT_EQ(1023u, h.get_percentile_upper_bound(91));
+
+  // values past the last bin are counted in it
+  h.add(UINT32_MAX);
+  ASSERT_EQ(1u, h.h[pow2_hist_fixed_t::NUM_BINS - 1]);
+
+  h.decay();
+  ASSERT_EQ(5u, h.h[0]);
+  ASSERT_EQ(40u, h.h[4]);
+  ASSERT_EQ(5u, h.h[10]);
+  ASSERT_EQ(0u, h.h[pow2_hist_fixed_t::NUM_BINS - 1]);
+
+  h.clear();
+  ASSERT_TRUE(h.empty());
+}
+
 /*
  * Local Variables:
  * compile-command: "cd ../.. ; make -j4 &&
@@ -2,7 +2,10 @@
 // vim: ts=8 sw=2 smarttab
 
 #include <iostream>
+#include <random>
 #include <string.h>
+#include <thread>
+#include <vector>
 
 #include "include/types.h"
 #include "include/crc32c.h"
@@ -363,3 +366,87 @@ TEST(Crc32c, zeros_performance) {
 
 }
 
+TEST(Crc32c, zeros_match_table) {
+  std::mt19937 rng(1234);
+  for (unsigned len = 0; len < 4096; len++) {
+    uint32_t crc = rng();
+    ASSERT_EQ(ceph_crc32c_sctp(crc, nullptr, len), ceph_crc32c_zeros(crc, len))
+      << "len " << len;
+  }
+  for (int i = 0; i < 100; i++) {
+    uint32_t crc = rng();
+    unsigned len = rng() % (64 << 20);
+    ASSERT_EQ(ceph_crc32c_sctp(crc, nullptr, len), ceph_crc32c_zeros(crc, len))
+      << "len " << len;
+  }
+}
+
+TEST(Crc32c, Combine) {
+  std::mt19937 rng(5678);
+  int len = 65536;
+  std::vector<unsigned char> a(len);
+  for (auto& c : a)
+    c = rng();
+  for (int i = 0; i < 1000; i++) {
+    uint32_t seed = rng();
+    unsigned split = rng() % (len + 1);
+    uint32_t whole = ceph_crc32c(seed, a.data(), len);
+    uint32_t crc_a = ceph_crc32c(seed, a.data(), split);
+    uint32_t crc_b = ceph_crc32c(0, a.data() + split, len - split);
+    ASSERT_EQ(whole, ceph_crc32c_combine(crc_a, crc_b, len - split));
+    // second half checksummed with some other initial value
+    uint32_t crc_b_ff = ceph_crc32c(0xffffffff, a.data() + split, len - split);
+    ASSERT_EQ(whole, ceph_crc32c_combine(crc_a ^ 0xffffffff, crc_b_ff,
+					 len - split));
+  }
+}
+
+TEST(Crc32c, combine_performance) {
+  constexpr size_t ITER = 1000000;
+  std::mt19937 rng(42);
+  std::vector<unsigned> lens(1024);
+  for (auto& l : lens)
+    l = rng() % (4 << 20);
+  uint32_t crc = 0;
+  utime_t start = ceph_clock_now();
+  for (size_t i = 0; i < ITER; i++) {
+    crc = ceph_crc32c_combine(crc, i, lens[i % lens.size()]);
+  }
+  utime_t end = ceph_clock_now();
+  std::cout << "combine: " << (double)(end - start) * 1e9 / ITER
+	    << " ns/call (" << crc << ")" << std::endl;
+
+  // a 4MB object checksummed as independent streams on several
+  // threads, then merged
+  int len = 4 << 20;
+  std::vector<unsigned char> a(len);
+  for (int i = 0; i < len; i++)
+    a[i] = i & 0xff;
+  uint32_t expected = ceph_crc32c(0, a.data(), len);
+  unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned n = 1; n <= std::min(max_threads, 16u); n *= 2) {
+    constexpr int ROUNDS = 100;
+    unsigned chunk = len / n;
+    std::vector<uint32_t> crcs(n);
+    start = ceph_clock_now();
+    for (int r = 0; r < ROUNDS; r++) {
+      std::vector<std::thread> threads;
+      for (unsigned t = 1; t < n; t++) {
+	threads.emplace_back([&, t] {
+	  crcs[t] = ceph_crc32c(0, a.data() + t * chunk, chunk);
+	});
+      }
+      crcs[0] = ceph_crc32c(0, a.data(), chunk);
+      for (auto& t : threads)
+	t.join();
+      crc = crcs[0];
+      for (unsigned t = 1; t < n; t++)
+	crc = ceph_crc32c_combine(crc, crcs[t], chunk);
+      ASSERT_EQ(expected, crc);
+    }
+    end = ceph_clock_now();
+    std::cout << n << " streams = "
+	      << (double)len * ROUNDS / (1024*1024) / (double)(end - start)
+	      << " MB/sec" << std::endl;
+  }
+}
@@ -14,6 +14,8 @@
 
 #include "common/perf_histogram.h"
 
+#include <thread>
+
 #include "gtest/gtest.h"
 
 template <int DIM>
@@ -245,3 +247,40 @@ TEST(PerfHistogram, AxisAddressing) {
     }
   }
 }
+
+TEST(PerfHistogram, Sharded) {
+  PerfHistogramCommon::axis_config_d ac1{"", PerfHistogramCommon::SCALE_LINEAR,
+                                         0, 1, 7};
+  PerfHistogramCommon::axis_config_d ac2{"", PerfHistogramCommon::SCALE_LINEAR,
+                                         0, 1, 9};
+
+  PerfHistogramAccessor<2> h{ac1, ac2};
+  h.set_sharded();
+
+  const int num_threads = 8;
+  const int num_incs = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&h, t] {
+      for (int i = 0; i < num_incs; ++i) {
+        h.inc(1, t % 2);  // buckets 2, 1 + t % 2
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(uint64_t(num_threads * num_incs / 2), h.read_bucket(2, 1));
+  ASSERT_EQ(uint64_t(num_threads * num_incs / 2), h.read_bucket(2, 2));
+
+  int64_t total = 0;
+  h.visit_values([](int) {}, [&total](int64_t value) { total += value; },
+                 [](int) {});
+  ASSERT_EQ(num_threads * num_incs, total);
+
+  PerfHistogramAccessor<2> copy{h};
+  ASSERT_EQ(uint64_t(num_threads * num_incs / 2), copy.read_bucket(2, 1));
+
+  h.reset();
+  ASSERT_EQ(0u, h.read_bucket(2, 1));
+}
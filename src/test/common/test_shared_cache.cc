@@ -32,8 +32,20 @@ class SharedLRUTest : public SharedLRU<unsigned int, int> {
 public:
   auto& get_lock() { return lock; }
   auto& get_cond() { return cond; }
-  map<unsigned int, pair< std::weak_ptr<int>, int* > > &get_weak_refs() {
-    return weak_refs;
+  void set_weak_ref(unsigned int key, const std::shared_ptr<int>& ptr) {
+    erase_weak_ref(key);
+    insert_ref(key, ptr);
+  }
+  bool weak_ref_alive(unsigned int key) {
+    return !weak_refs.at(key).weak.expired();
+  }
+  void erase_weak_ref(unsigned int key) {
+    index.erase(key);
+    weak_refs.erase(key);
+  }
+  void clear_weak_refs() {
+    index.clear();
+    weak_refs.clear();
   }
 };
 
@@ -172,9 +184,9 @@ TEST_F(SharedLRU_all, wait_lookup) {
 
   {
     std::shared_ptr<int> ptr(new int);
-    cache.get_weak_refs()[key] = make_pair(ptr, &*ptr);
+    cache.set_weak_ref(key, ptr);
   }
-  EXPECT_FALSE(cache.get_weak_refs()[key].first.lock());
+  EXPECT_FALSE(cache.weak_ref_alive(key));
 
   Thread_wait t(cache, key, value, Thread_wait::LOOKUP);
   t.create("wait_lookup_1");
@@ -184,7 +196,7 @@ TEST_F(SharedLRU_all, wait_lookup) {
   EXPECT_FALSE(cache.lookup(key + 12345));
   {
     std::lock_guard l{cache.get_lock()};
-    cache.get_weak_refs().erase(key);
+    cache.erase_weak_ref(key);
     cache.get_cond().notify_one();
   }
   ASSERT_TRUE(wait_for(cache, 0));
@@ -198,9 +210,9 @@ TEST_F(SharedLRU_all, wait_lookup_or_create) {
 
   {
     std::shared_ptr<int> ptr(new int);
-    cache.get_weak_refs()[key] = make_pair(ptr, &*ptr);
+    cache.set_weak_ref(key, ptr);
   }
-  EXPECT_FALSE(cache.get_weak_refs()[key].first.lock());
+  EXPECT_FALSE(cache.weak_ref_alive(key));
 
   Thread_wait t(cache, key, value, Thread_wait::LOOKUP);
   t.create("wait_lookup_2");
@@ -210,7 +222,7 @@ TEST_F(SharedLRU_all, wait_lookup_or_create) {
   EXPECT_TRUE(cache.lookup_or_create(key + 12345).get());
   {
     std::lock_guard l{cache.get_lock()};
-    cache.get_weak_refs().erase(key);
+    cache.erase_weak_ref(key);
     cache.get_cond().notify_one();
   }
   ASSERT_TRUE(wait_for(cache, 0));
@@ -243,9 +255,9 @@ TEST_F(SharedLRU_all, wait_lower_bound) {
 
   {
     std::shared_ptr<int> ptr(new int);
-    cache.get_weak_refs()[key] = make_pair(ptr, &*ptr);
+    cache.set_weak_ref(key, ptr);
   }
-  EXPECT_FALSE(cache.get_weak_refs()[key].first.lock());
+  EXPECT_FALSE(cache.weak_ref_alive(key));
 
   Thread_wait t(cache, key, value, Thread_wait::LOWER_BOUND);
   t.create("wait_lower_bnd");
@@ -255,7 +267,7 @@ TEST_F(SharedLRU_all, wait_lower_bound) {
   EXPECT_TRUE(cache.lower_bound(other_key).get());
   {
     std::lock_guard l{cache.get_lock()};
-    cache.get_weak_refs().erase(key);
+    cache.erase_weak_ref(key);
     cache.get_cond().notify_one();
   }
   ASSERT_TRUE(wait_for(cache, 0));
@@ -279,7 +291,7 @@ TEST_F(SharedLRU_all, get_next) {
 
     // entries with expired pointers are silently ignored
     const unsigned int key_gone = 222;
-    cache.get_weak_refs()[key_gone] = make_pair(std::shared_ptr<int>(), (int*)0);
+    cache.set_weak_ref(key_gone, std::shared_ptr<int>());
 
     const unsigned int key1 = 111;
     std::shared_ptr<int> ptr1 = cache.lookup_or_create(key1);
@@ -296,7 +308,7 @@ TEST_F(SharedLRU_all, get_next) {
 
     EXPECT_FALSE(cache.get_next(i.first, &i));
 
-    cache.get_weak_refs().clear();
+    cache.clear_weak_refs();
   }
   {
     SharedLRUTest cache;
@@ -122,6 +122,19 @@ TEST(EscapeJson, ControlChars) {
   ASSERT_EQ(escape_json_stream("abc\x7f"), "abc\\u007f");
 }
 
+TEST(EscapeJson, LongStrings) {
+  // the stream escaper checks 8 characters at a time: put each special
+  // (or almost special) character at every offset of a few of those words
+  for (char c : {'"', '\\', '\t', '\n', '\x01', '\x1f', ' ', '\x7f', '\x80'}) {
+    for (size_t pos = 0; pos < 24; ++pos) {
+      std::string s(24, 'a');
+      s[pos] = c;
+      s += "\xe6\xb1\x89";
+      ASSERT_EQ(escape_json_attrs(s.c_str()), escape_json_stream(s.c_str()));
+    }
+  }
+}
+
 TEST(EscapeJson, Utf8) {
   EXPECT_EQ(escape_json_attrs("\xe6\xb1\x89\xe5\xad\x97\n"), "\xe6\xb1\x89\xe5\xad\x97\\n");
   EXPECT_EQ(escape_json_stream("\xe6\xb1\x89\xe5\xad\x97\n"), "\xe6\xb1\x89\xe5\xad\x97\\n");
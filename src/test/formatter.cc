@@ -15,7 +15,10 @@
 #include "gtest/gtest.h"
 #include "common/Formatter.h"
 #include "common/HTMLFormatter.h"
+#include "common/ceph_time.h"
+#include "include/buffer.h"
 
+#include <iostream>
 #include <sstream>
 #include <string>
 
@@ -69,6 +72,134 @@ TEST(JsonFormatter, Empty) {
   ASSERT_EQ(oss.str(), "");
 }
 
+TEST(JsonFormatter, FlushBufferlist) {
+  for (bool pretty : {false, true}) {
+    JSONFormatter fmt(pretty);
+    fmt.enable_line_break();
+    fmt.open_object_section("foo");
+    fmt.dump_int("a", -1);
+    fmt.dump_stream("b") << "pending";
+    fmt.close_section();
+    bufferlist bl;
+    fmt.flush(bl);
+    ASSERT_EQ(pretty ? "{\n    \"a\": -1,\n    \"b\": \"pending\"\n}\n\n" :
+                       "{\"a\":-1,\"b\":\"pending\"}\n",
+              bl.to_str());
+  }
+}
+
+// something shaped like the pg_stats of a 'pg dump'
+static void dump_synthetic_pg_stats(Formatter *f, int num_pgs)
+{
+  f->open_object_section("pg_map");
+  f->dump_unsigned("version", 123456);
+  f->dump_stream("stamp") << "2024-05-01T12:34:56.789012+0000";
+  f->open_array_section("pg_stats");
+  for (int i = 0; i < num_pgs; ++i) {
+    f->open_object_section("pg_stat");
+    f->dump_stream("pgid") << (i % 7 + 1) << '.' << std::hex << i << std::dec;
+    f->dump_stream("version") << "1234'" << i * 3;
+    f->dump_unsigned("reported_seq", 100000 + i);
+    f->dump_string("state", i % 100 ? "active+clean" : "active+clean+scrubbing+deep");
+    for (auto stamp : {"last_fresh", "last_change", "last_active", "last_peered",
+                       "last_clean", "last_scrub_stamp"}) {
+      f->dump_string(stamp, "2024-05-01T12:34:56.789012+0000");
+    }
+    f->dump_int("log_size", 3000 + i % 100);
+    f->dump_int("ondisk_log_size", 3000 + i % 100);
+    f->dump_bool("stats_invalid", false);
+    f->dump_float("scrub_duration", 1.5 + i % 13);
+    f->open_object_section("stat_sum");
+    for (auto name : {"num_bytes", "num_objects", "num_object_clones",
+                      "num_object_copies", "num_objects_degraded",
+                      "num_objects_unfound", "num_read", "num_read_kb",
+                      "num_write", "num_write_kb", "num_scrub_errors",
+                      "num_objects_recovered", "num_bytes_recovered",
+                      "num_keys_recovered", "num_objects_omap"}) {
+      f->dump_int(name, int64_t(i) * 4096 + 17);
+    }
+    f->close_section();
+    f->open_array_section("up");
+    for (int j = 0; j < 3; ++j) {
+      f->dump_int("osd", (i + j) % 100);
+    }
+    f->close_section();
+    f->dump_int("up_primary", i % 100);
+    f->close_section();
+  }
+  f->close_section();
+  f->close_section();
+}
+
+TEST(JsonFormatterStream, SameOutput) {
+  for (bool pretty : {false, true}) {
+    JSONFormatter expected(pretty);
+    JSONFormatterStream actual(pretty);
+    dump_synthetic_pg_stats(&expected, 1000);
+    dump_synthetic_pg_stats(&actual, 1000);
+    ASSERT_EQ(expected.get_len(), actual.get_len());
+    bufferlist ebl, abl;
+    expected.flush(ebl);
+    actual.flush(abl);
+    ASSERT_GT(abl.get_num_buffers(), 1u);
+    ASSERT_EQ(ebl, abl);
+    ASSERT_EQ(0, actual.get_len());
+
+    // and it can be reused after a flush or reset
+    actual.open_object_section("foo");
+    actual.dump_int("a", 1);
+    actual.reset();
+    actual.open_object_section("bar");
+    actual.dump_int("b", 2);
+    actual.close_section();
+    ostringstream oss;
+    actual.flush(oss);
+    ASSERT_EQ(pretty ? "{\n    \"b\": 2\n}\n" : "{\"b\":2}", oss.str());
+  }
+}
+
+TEST(JsonFormatterStream, Sink) {
+  bufferlist sunk;
+  int chunks = 0;
+  JSONFormatterStream fmt(false, [&](bufferlist&& bl) {
+    ++chunks;
+    sunk.claim_append(bl);
+  });
+  dump_synthetic_pg_stats(&fmt, 1000);
+  // most of the output has been handed over before the flush
+  ASSERT_GT(chunks, 1);
+  ASSERT_GT(sunk.length(), unsigned(fmt.get_len()));
+  fmt.flush(sunk);
+
+  JSONFormatter expected(false);
+  dump_synthetic_pg_stats(&expected, 1000);
+  bufferlist ebl;
+  expected.flush(ebl);
+  ASSERT_EQ(ebl, sunk);
+}
+
+TEST(JsonFormatterStream, BenchPGDump) {
+  const int num_pgs = 20000;
+  auto bench = [&](const char *what, Formatter *f) {
+    auto start = ceph::mono_clock::now();
+    dump_synthetic_pg_stats(f, num_pgs);
+    bufferlist bl;
+    f->flush(bl);
+    double secs = std::chrono::duration<double>(
+      ceph::mono_clock::now() - start).count();
+    std::cout << what << ": " << num_pgs << " pgs, " << bl.length()
+              << " bytes in " << secs * 1000 << " ms, "
+              << bl.length() / secs / (1 << 20) << " MB/s" << std::endl;
+  };
+  for (bool pretty : {false, true}) {
+    JSONFormatter old_fmt(pretty);
+    JSONFormatterStream new_fmt(pretty);
+    bench(pretty ? "JSONFormatter (pretty)" : "JSONFormatter", &old_fmt);
+    bench(pretty ? "JSONFormatterStream (pretty)" : "JSONFormatterStream",
+          &new_fmt);
+  }
+}
+
 TEST(XmlFormatter, Simple1) {
   ostringstream oss;
   XMLFormatter fmt(false);
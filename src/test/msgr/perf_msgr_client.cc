@@ -169,7 +169,8 @@ void usage(const string &name) {
   cout << "Usage: " << name << " [server ip:port] [numjobs] [concurrency] [ios] [thinktime us] [msg length]" << std::endl;
   cout << "       [server ip:port]: connect to the ip:port pair" << std::endl;
   cout << "       [numjobs]: how much client threads spawned and do benchmark" << std::endl;
-  cout << "       [concurrency]: the max inflight messages(like iodepth in fio)" << std::endl;
+  cout << "       [concurrency]: the max inflight messages(like iodepth in fio)," << std::endl;
+  cout << "                      0 to ping-pong one message at a time and report round trip latency" << std::endl;
   cout << "       [ios]: how much messages sent for each client" << std::endl;
   cout << "       [thinktime]: sleep time when do fast dispatching(match client logic)" << std::endl;
   cout << "       [msg length]: message data bytes" << std::endl;
@@ -214,6 +215,10 @@ int main(int argc, char **argv)
   client.start();
   uint64_t stop = Cycles::rdtsc();
   cout << " Total op " << (ios * numjobs) << " run time " << Cycles::to_microseconds(stop - start) << "us." << std::endl;
+  if (concurrent == 0 && ios > 0) {
+    // every job waits for the reply before sending the next message
+    cout << " Avg round trip " << Cycles::to_nanoseconds(stop - start) / ios / 1000.0 << "us." << std::endl;
+  }
 
   return 0;
 }
@@ -147,6 +147,17 @@ static bufferlist make_bufferlist(size_t len, char c) {
   return bl;
 }
 
+// the same contents, in buffers of at most frag_len bytes
+static bufferlist fragment_bufferlist(const bufferlist& in, size_t frag_len) {
+  bufferlist bl;
+  for (unsigned off = 0; off < in.length(); off += frag_len) {
+    bufferlist frag;
+    frag.substr_of(in, off, std::min<size_t>(frag_len, in.length() - off));
+    bl.append(buffer::copy(frag.c_str(), frag.length()));
+  }
+  return bl;
+}
+
 bool disassemble_frame(FrameAssembler& frame_asm, bufferlist& frame_bl,
                        Tag& tag, segment_bls_t& segment_bls) {
   bufferlist preamble_bl;
@@ -232,8 +243,13 @@ protected:
                       frame_asm.get_frame_onwire_len());
   }
 
-  void test_round_trip() {
-    auto tx_frame = TestFrame::Encode(m_header, m_front, m_middle, m_data);
+  void test_round_trip(size_t frag_len = 0) {
+    auto tx_frame = frag_len == 0 ?
+      TestFrame::Encode(m_header, m_front, m_middle, m_data) :
+      TestFrame::Encode(fragment_bufferlist(m_header, frag_len),
+			fragment_bufferlist(m_front, frag_len),
+			fragment_bufferlist(m_middle, frag_len),
+			fragment_bufferlist(m_data, frag_len));
     auto onwire_bl = tx_frame.get_buffer(m_tx_frame_asm);
     check_frame_assembler(m_tx_frame_asm);
     EXPECT_EQ(m_tx_frame_asm.get_frame_onwire_len(), onwire_bl.length());
@@ -279,6 +295,12 @@ TEST_P(RoundTripTest, Reuse) {
   }
 }
 
+TEST_P(RoundTripTest, Fragmented) {
+  for (size_t frag_len : {1, 7, 16, 100}) {
+    test_round_trip(frag_len);
+  }
+}
+
 static const round_trip_instance_t round_trip_instances[] = {
   // first segment is empty
   { 0,   0,   0,   0, 1, {{32,  0,  17,   0,   0,  0},
@@ -1584,6 +1584,254 @@ TEST_P(MessengerTest, MessageTest) {
 }
 
 
+/*
+ * Takes MCommand (carrying a per connection sequence number in cmd[0])
+ * through sharded dispatch, and can park ms_dispatch2 to let messages
+ * pile up on the shards.
+ */
+class ShardedDispatcher : public Dispatcher {
+ public:
+  ceph::mutex lock = ceph::make_mutex("ShardedDispatcher::lock");
+  ceph::condition_variable cond;
+  bool hold = false;       ///< park ms_dispatch2 until cleared
+  ConnectionRef held;      ///< connection of the parked message
+  unsigned dispatched = 0;
+  unsigned out_of_order = 0;
+  map<ConnectionRef, int> last_seq;
+
+  ShardedDispatcher() : Dispatcher(g_ceph_context) {}
+
+  bool ms_can_sharded_dispatch(const MessageConstRef& m) const override {
+    return m->get_type() == MSG_COMMAND;
+  }
+  bool ms_dispatch2(const MessageRef& m) override {
+    ceph_assert(m->get_type() == MSG_COMMAND);
+    std::unique_lock l{lock};
+    if (hold) {
+      held = m->get_connection();
+      cond.notify_all();
+      cond.wait(l, [this] { return !hold; });
+    }
+    int seq = std::stoi(static_cast<MCommand*>(m.get())->cmd[0]);
+    auto& last = last_seq[m->get_connection()];
+    if (seq != last + 1) {
+      ++out_of_order;
+    }
+    last = seq;
+    ++dispatched;
+    cond.notify_all();
+    return true;
+  }
+  bool ms_handle_reset(Connection *con) override { return true; }
+  void ms_handle_remote_reset(Connection *con) override {}
+  bool ms_handle_refused(Connection *con) override { return false; }
+};
+
+// sits ahead of ShardedDispatcher without opting in, so it must never
+// be handed sharded messages
+class BystanderDispatcher : public Dispatcher {
+ public:
+  atomic<unsigned> seen = {0};
+
+  BystanderDispatcher() : Dispatcher(g_ceph_context) {}
+
+  bool ms_dispatch2(const MessageRef& m) override {
+    if (m->get_type() == MSG_COMMAND) {
+      ++seen;
+    }
+    return false;
+  }
+  bool ms_handle_reset(Connection *con) override { return false; }
+  void ms_handle_remote_reset(Connection *con) override {}
+  bool ms_handle_refused(Connection *con) override { return false; }
+};
+
+TEST_P(MessengerTest, ShardedDispatchTest) {
+  constexpr int NUM_CLIENTS = 4;
+  constexpr int NUM_MSGS = 500;
+  g_ceph_context->_conf.set_val("ms_dispatch_shards", "3");
+  Messenger *srv = Messenger::create(g_ceph_context, string(GetParam()),
+				     entity_name_t::OSD(1), "sharded",
+				     getpid());
+  g_ceph_context->_conf.set_val("ms_dispatch_shards", "0");
+  srv->set_default_policy(Messenger::Policy::stateless_server(0));
+  srv->set_auth_client(&dummy_auth);
+  srv->set_auth_server(&dummy_auth);
+  srv->set_require_authorizer(false);
+  ShardedDispatcher sharded;
+  BystanderDispatcher bystander;
+  entity_addr_t bind_addr;
+  bind_addr.parse("v2:127.0.0.1");
+  srv->bind(bind_addr);
+  srv->add_dispatcher_head(&bystander);
+  srv->add_dispatcher_tail(&sharded);
+  srv->start();
+
+  vector<Messenger*> clients;
+  vector<ConnectionRef> conns;
+  for (int i = 0; i < NUM_CLIENTS; ++i) {
+    Messenger *c = Messenger::create(g_ceph_context, string(GetParam()),
+				     entity_name_t::CLIENT(-1),
+				     "client" + to_string(i), getpid() + i + 1);
+    c->set_default_policy(Messenger::Policy::lossy_client(0));
+    c->set_auth_client(&dummy_auth);
+    c->set_auth_server(&dummy_auth);
+    c->start();
+    clients.push_back(c);
+    conns.push_back(c->connect_to(srv->get_mytype(), srv->get_myaddrs()));
+  }
+  auto send = [](ConnectionRef& con, int seq) {
+    uuid_d uuid;
+    MCommand *m = new MCommand(uuid);
+    m->cmd = {to_string(seq)};
+    con->send_message(m);
+  };
+
+  // 1. connections spread over the shards each keep their order, and
+  // only the dispatcher that opted in sees the messages
+  for (int i = 1; i <= NUM_MSGS; ++i) {
+    for (auto& con : conns) {
+      send(con, i);
+    }
+  }
+  {
+    std::unique_lock l{sharded.lock};
+    sharded.cond.wait_for(l, 60s, [&] {
+      return sharded.dispatched == NUM_CLIENTS * NUM_MSGS;
+    });
+    ASSERT_EQ(NUM_CLIENTS * NUM_MSGS, (int)sharded.dispatched);
+    ASSERT_EQ(0u, sharded.out_of_order);
+    ASSERT_EQ(NUM_CLIENTS, (int)sharded.last_seq.size());
+  }
+  ASSERT_EQ(0u, bystander.seen);
+
+  // 2. marking a connection down drops what it has queued on its shard
+  {
+    std::unique_lock l{sharded.lock};
+    sharded.hold = true;
+  }
+  for (int i = NUM_MSGS + 1; i <= NUM_MSGS + 10; ++i) {
+    send(conns[0], i);
+  }
+  ConnectionRef srv_con;
+  {
+    std::unique_lock l{sharded.lock};
+    sharded.cond.wait_for(l, 60s, [&] { return sharded.held != nullptr; });
+    ASSERT_TRUE(sharded.held);
+    srv_con = sharded.held;
+  }
+  CHECK_AND_WAIT_TRUE(srv->get_dispatch_queue_len() == 9);
+  ASSERT_EQ(9, srv->get_dispatch_queue_len());
+  srv_con->mark_down();
+  ASSERT_EQ(0, srv->get_dispatch_queue_len());
+  {
+    std::unique_lock l{sharded.lock};
+    sharded.hold = false;
+    sharded.held.reset();
+    sharded.cond.notify_all();
+    sharded.cond.wait_for(l, 60s, [&] {
+      return sharded.dispatched == NUM_CLIENTS * NUM_MSGS + 1;
+    });
+  }
+  usleep(100000);
+  {
+    std::unique_lock l{sharded.lock};
+    ASSERT_EQ(NUM_CLIENTS * NUM_MSGS + 1, (int)sharded.dispatched);
+  }
+
+  // 3. shutdown with messages still queued on a shard
+  {
+    std::unique_lock l{sharded.lock};
+    sharded.hold = true;
+  }
+  for (int i = NUM_MSGS + 1; i <= NUM_MSGS + 10; ++i) {
+    send(conns[1], i);
+  }
+  {
+    std::unique_lock l{sharded.lock};
+    sharded.cond.wait_for(l, 60s, [&] { return sharded.held != nullptr; });
+    ASSERT_TRUE(sharded.held);
+  }
+  CHECK_AND_WAIT_TRUE(srv->get_dispatch_queue_len() == 9);
+  srv->shutdown();
+  {
+    std::unique_lock l{sharded.lock};
+    sharded.hold = false;
+    sharded.held.reset();
+    sharded.cond.notify_all();
+  }
+  srv->wait();
+  ASSERT_EQ(0, srv->get_dispatch_queue_len());
+  {
+    std::unique_lock l{sharded.lock};
+    ASSERT_EQ(0u, sharded.out_of_order);
+  }
+  ASSERT_EQ(0u, bystander.seen);
+
+  for (auto c : clients) {
+    c->shutdown();
+    c->wait();
+    delete c;
+  }
+  conns.clear();
+  sharded.last_seq.clear();
+  delete srv;
+}
+
+TEST_P(MessengerTest, WriteBatchTest) {
+  constexpr int NUM_MSGS = 2000;
+  // ShardedDispatcher checks the per connection order; there are no
+  // dispatch shards here, so it gets the messages from the main queue
+  ShardedDispatcher srv_dispatcher;
+  entity_addr_t bind_addr;
+  bind_addr.parse("v2:127.0.0.1");
+  server_msgr->bind(bind_addr);
+  server_msgr->add_dispatcher_head(&srv_dispatcher);
+  server_msgr->start();
+  client_msgr->start();
+
+  ConnectionRef conn = client_msgr->connect_to(server_msgr->get_mytype(),
+					       server_msgr->get_myaddrs());
+  int seq = 0;
+  auto send = [&conn, &seq] {
+    uuid_d uuid;
+    MCommand *m = new MCommand(uuid);
+    m->cmd = {to_string(++seq)};
+    ASSERT_EQ(0, conn->send_message(m));
+  };
+  auto wait_for_all = [&srv_dispatcher, &seq] {
+    std::unique_lock l{srv_dispatcher.lock};
+    srv_dispatcher.cond.wait_for(l, 60s, [&] {
+      return (int)srv_dispatcher.dispatched == seq;
+    });
+    ASSERT_EQ(seq, (int)srv_dispatcher.dispatched);
+    ASSERT_EQ(0u, srv_dispatcher.out_of_order);
+  };
+
+  for (auto batch_bytes : {"0", "4096", "65536"}) {
+    g_ceph_context->_conf.set_val("ms_async_write_batch_bytes", batch_bytes);
+    // a burst backs up the out queue, so that frames get batched (unless
+    // batching is off); they must all arrive in order
+    for (int i = 0; i < NUM_MSGS; ++i) {
+      send();
+    }
+    wait_for_all();
+    // a message sent once the queue has drained is not held back
+    // waiting for more to join it
+    send();
+    wait_for_all();
+  }
+  g_ceph_context->_conf.set_val("ms_async_write_batch_bytes", "65536");
+
+  conn->mark_down();
+  server_msgr->shutdown();
+  client_msgr->shutdown();
+  server_msgr->wait();
+  client_msgr->wait();
+  srv_dispatcher.last_seq.clear();
+}
+
+
 class SyntheticWorkload;
 
 struct Payload {
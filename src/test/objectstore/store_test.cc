@@ -7018,6 +7018,123 @@ TEST_P(StoreTest, BluestoreOnOffCSumTest) {
 }
 #endif
 
+TEST_P(StoreTest, ReadCrc32c) {
+  int r;
+  coll_t cid;
+  ghobject_t hoid(hobject_t(sobject_t("Object 1", CEPH_NOSNAP)));
+  auto ch = store->create_new_collection(cid);
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  std::vector<const char*> csum_types = {"crc32c"};
+  if (string(GetParam()) == "bluestore") {
+    // crc32c blobs are composed from their csums, the others hashed
+    csum_types.push_back("xxhash64");
+  }
+  for (auto csum_type : csum_types) {
+    SetVal(g_conf(), "bluestore_csum_type", csum_type);
+    g_conf().apply_changes(nullptr);
+    cerr << "csum type " << csum_type << std::endl;
+    {
+      // unaligned writes, a hole, a zeroed range and a truncated tail
+      ObjectStore::Transaction t;
+      bufferlist bl;
+      t.remove(cid, hoid);
+      t.touch(cid, hoid);
+      bl.append(std::string(100000, 'a'));
+      t.write(cid, hoid, 0, bl.length(), bl);
+      bl.clear();
+      bl.append(std::string(5000, 'b'));
+      t.write(cid, hoid, 65535, bl.length(), bl);
+      bl.clear();
+      bl.append(std::string(200000, 'c'));
+      t.write(cid, hoid, 300001, bl.length(), bl);
+      t.zero(cid, hoid, 4096, 8193);
+      t.truncate(cid, hoid, 450003);
+      r = queue_transaction(store, ch, std::move(t));
+      ASSERT_EQ(r, 0);
+    }
+    for (uint32_t flags : {0u, (unsigned)CEPH_OSD_OP_FLAG_BYPASS_CLEAN_CACHE}) {
+      for (auto [off, len] : std::vector<std::pair<uint64_t, uint64_t>>{
+	  {0, 0}, {0, 524288}, {0, 4096}, {1, 70000}, {65536, 4096},
+	  {99999, 250000}, {300000, 524288}, {450000, 100}, {500000, 10}}) {
+	uint32_t seed = off * 7 + len;
+	bufferlist bl;
+	int read_r = store->read(ch, hoid, off, len, bl, flags);
+	uint32_t crc = seed;
+	r = store->read_crc32c(ch, hoid, off, len, &crc, flags);
+	ASSERT_EQ(read_r, r) << off << "~" << len;
+	ASSERT_EQ(bl.crc32c(seed), crc) << off << "~" << len;
+      }
+    }
+  }
+  SetVal(g_conf(), "bluestore_csum_type", "crc32c");
+  g_conf().apply_changes(nullptr);
+  {
+    ObjectStore::Transaction t;
+    t.remove(cid, hoid);
+    t.remove_collection(cid);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+}
+
+TEST_P(StoreTest, GetDeviceOffsets) {
+  int r;
+  coll_t cid;
+  auto ch = store->create_new_collection(cid);
+  {
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  std::vector<ghobject_t> oids;
+  for (auto name : {"a", "b", "c", "empty", "hole", "missing"}) {
+    oids.emplace_back(hobject_t(sobject_t(name, CEPH_NOSNAP)));
+  }
+  {
+    ObjectStore::Transaction t;
+    bufferlist bl;
+    bl.append(std::string(65536, 'x'));
+    for (size_t i = 0; i < 3; ++i) {
+      t.write(cid, oids[i], 0, bl.length(), bl);
+    }
+    t.touch(cid, oids[3]);
+    t.truncate(cid, oids[4], 65536);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+  std::vector<uint64_t> offsets;
+  r = store->get_device_offsets(ch, oids, &offsets);
+  if (string(GetParam()) != "bluestore") {
+    ASSERT_EQ(-EOPNOTSUPP, r);
+  } else {
+    ASSERT_EQ(0, r);
+    ASSERT_EQ(oids.size(), offsets.size());
+    std::set<uint64_t> seen;
+    for (size_t i = 0; i < 3; ++i) {
+      ASSERT_NE(UINT64_MAX, offsets[i]) << oids[i];
+      ASSERT_TRUE(seen.insert(offsets[i]).second) << oids[i];
+    }
+    for (size_t i = 3; i < oids.size(); ++i) {
+      ASSERT_EQ(UINT64_MAX, offsets[i]) << oids[i];
+    }
+  }
+  {
+    ObjectStore::Transaction t;
+    for (size_t i = 0; i < 5; ++i) {
+      t.remove(cid, oids[i]);
+    }
+    t.remove_collection(cid);
+    r = queue_transaction(store, ch, std::move(t));
+    ASSERT_EQ(r, 0);
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
   ObjectStore,
   StoreTest,
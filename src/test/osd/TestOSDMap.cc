@@ -1628,6 +1628,87 @@ TEST_F(OSDMapTest, BUG_40104) {
   }
 }
 
+TEST_F(OSDMapTest, MapPGRangeMatches) {
+  int osd_num = 600;
+  int pg_num = 4096;
+  set_up_map(osd_num);
+  int pool_id;
+  {
+    OSDMap::Incremental pending_inc(osdmap.get_epoch() + 1);
+    pending_inc.new_pool_max = osdmap.get_pool_max();
+    pool_id = ++pending_inc.new_pool_max;
+    pg_pool_t empty;
+    auto p = pending_inc.get_new_pool(pool_id, &empty);
+    p->size = 3;
+    p->min_size = 1;
+    p->set_pg_num(pg_num);
+    p->set_pgp_num(pg_num);
+    p->type = pg_pool_t::TYPE_REPLICATED;
+    p->crush_rule = 0;
+    p->set_flag(pg_pool_t::FLAG_HASHPSPOOL);
+    pending_inc.new_pool_names[pool_id] = "range_pool";
+    osdmap.apply_incremental(pending_inc);
+  }
+  {
+    // exercise everything applied on top of the raw crush output
+    OSDMap::Incremental pending_inc(osdmap.get_epoch() + 1);
+    pending_inc.new_weight[1] = CEPH_OSD_OUT;
+    pending_inc.new_weight[2] = CEPH_OSD_IN / 2;
+    pending_inc.new_state[3] = CEPH_OSD_UP;
+    pending_inc.new_primary_affinity[4] = 0;
+    pg_t temp_pg(1, pool_id);
+    pending_inc.new_pg_temp[temp_pg] =
+      mempool::osdmap::vector<int>({5, 6, 7});
+    pending_inc.new_primary_temp[pg_t(2, pool_id)] = 8;
+    pending_inc.new_pg_upmap_items[pg_t(3, pool_id)] =
+      mempool::osdmap::vector<pair<int32_t,int32_t>>();
+    vector<int> up;
+    int up_primary;
+    osdmap.pg_to_raw_up(pg_t(3, pool_id), &up, &up_primary);
+    pending_inc.new_pg_upmap_items[pg_t(3, pool_id)].push_back(
+      make_pair(up[0], osd_num - 1));
+    osdmap.apply_incremental(pending_inc);
+  }
+  for (auto pool : {(int64_t)my_ec_pool, (int64_t)my_rep_pool,
+		    (int64_t)pool_id}) {
+    ps_t pool_pg_num = osdmap.get_pg_pool(pool)->get_pg_num();
+    ps_t next = 0;
+    osdmap.pg_range_to_up_acting_osds(
+      pool, 0, pool_pg_num,
+      [&](ps_t ps, vector<int>&& up, int up_primary,
+	  vector<int>&& acting, int acting_primary) {
+	ASSERT_EQ(next++, ps);
+	vector<int> up2, acting2;
+	int up_primary2, acting_primary2;
+	osdmap.pg_to_up_acting_osds(pg_t(ps, pool), &up2, &up_primary2,
+				    &acting2, &acting_primary2);
+	ASSERT_EQ(up2, up);
+	ASSERT_EQ(up_primary2, up_primary);
+	ASSERT_EQ(acting2, acting);
+	ASSERT_EQ(acting_primary2, acting_primary);
+      });
+    ASSERT_EQ(pool_pg_num, next);
+  }
+  {
+    auto start = mono_clock::now();
+    for (int ps = 0; ps < pg_num; ++ps) {
+      vector<int> up, acting;
+      int up_primary, acting_primary;
+      osdmap.pg_to_up_acting_osds(pg_t(ps, pool_id), &up, &up_primary,
+				  &acting, &acting_primary);
+    }
+    auto per_pg = mono_clock::now() - start;
+    start = mono_clock::now();
+    osdmap.pg_range_to_up_acting_osds(
+      pool_id, 0, pg_num,
+      [](ps_t, vector<int>&&, int, vector<int>&&, int) {});
+    auto range = mono_clock::now() - start;
+    std::cout << "mapping " << pg_num << " pgs on " << osd_num
+	      << " osds: per pg " << timespan_str(per_pg)
+	      << ", by range " << timespan_str(range) << std::endl;
+  }
+}
+
 TEST_F(OSDMapTest, BUG_42052) {
   // https://tracker.ceph.com/issues/42052
   set_up_map(6, true);
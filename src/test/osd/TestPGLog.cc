@@ -2234,7 +2234,7 @@ TEST_F(PGLogTest, ErrorNotIndexedByObject) {
   log.add(modify);
 
   EXPECT_TRUE(log.logged_object(oid));
-  pg_log_entry_t *entry = log.objects[oid];
+  pg_log_entry_t *entry = log.objects.find(oid)->second;
   EXPECT_EQ(modify.op, entry->op);
   EXPECT_EQ(modify.version, entry->version);
   EXPECT_EQ(modify.prior_version, entry->prior_version);
@@ -2248,7 +2248,7 @@ TEST_F(PGLogTest, ErrorNotIndexedByObject) {
   log.add(del);
 
   EXPECT_TRUE(log.logged_object(oid));
-  entry = log.objects[oid];
+  entry = log.objects.find(oid)->second;
   EXPECT_EQ(del.op, entry->op);
   EXPECT_EQ(del.version, entry->version);
   EXPECT_EQ(del.prior_version, entry->prior_version);
@@ -2261,7 +2261,7 @@ TEST_F(PGLogTest, ErrorNotIndexedByObject) {
 		   utime_t(20,1), -ENOENT));
 
   EXPECT_TRUE(log.logged_object(oid));
-  entry = log.objects[oid];
+  entry = log.objects.find(oid)->second;
   EXPECT_EQ(del.op, entry->op);
   EXPECT_EQ(del.version, entry->version);
   EXPECT_EQ(del.prior_version, entry->prior_version);
@@ -2372,6 +2372,114 @@ TEST_F(PGLogTestRebuildMissing, MissingNotInLog) {
   run_rebuild_missing_test(expected);
 }
 
+TEST_F(PGLogTestRebuildMissing, NewestEntryOnly) {
+  log.add(mk_ple_mod(existing_oid, mk_evt(6, 2), mk_evt(6, 1)));
+  log.add(mk_ple_mod(nonexistent_oid, mk_evt(7, 3), mk_evt(0, 0)));
+  log.add(mk_ple_mod(existing_oid, mk_evt(7, 4), mk_evt(6, 2)));
+  log.add(mk_ple_dt(nonexistent_oid, mk_evt(7, 5), mk_evt(7, 3)));
+  log.add(mk_ple_err(existing_oid, mk_evt(7, 6)));
+  map<hobject_t, pg_missing_item> expected;
+  expected[existing_oid] = pg_missing_item(mk_evt(7, 4), mk_evt(6, 2), false);
+  expected[nonexistent_oid] = pg_missing_item(mk_evt(7, 5), mk_evt(0, 0), true);
+  run_rebuild_missing_test(expected);
+}
+
+TEST_F(PGLogTestRebuildMissing, SkipCompleteAndBackfill) {
+  hobject_t backfilled = std::min(nonexistent_oid, mk_obj(10));
+  hobject_t not_backfilled = std::max(nonexistent_oid, mk_obj(10));
+  log.add(mk_ple_mod(existing_oid, mk_evt(7, 3), mk_evt(6, 2)));
+  log.add(mk_ple_mod(backfilled, mk_evt(7, 4), mk_evt(0, 0)));
+  log.add(mk_ple_mod(not_backfilled, mk_evt(7, 5), mk_evt(0, 0)));
+  info.last_complete = mk_evt(7, 3);
+  info.last_backfill = backfilled;
+  map<hobject_t, pg_missing_item> expected;
+  expected[backfilled] = pg_missing_item(mk_evt(7, 4), mk_evt(0, 0), false);
+  run_rebuild_missing_test(expected);
+}
+
+
+class PGLogOnDiskTrimTest : public PGLogTestRebuildMissing {
+public:
+  ghobject_t log_oid{hobject_t(object_t("log"), "", CEPH_NOSNAP, 0, 1, "")};
+
+  void SetUp() override {
+    PGLogTestRebuildMissing::SetUp();
+    cct->_conf.set_val_or_die("osd_pg_log_dups_tracked", "4");
+  }
+  void TearDown() override {
+    cct->_conf.set_val_or_die("osd_pg_log_dups_tracked", "3000");
+    PGLogTestRebuildMissing::TearDown();
+  }
+
+  void add_up_to(unsigned to) {
+    entity_name_t client = entity_name_t::CLIENT(777);
+    for (unsigned v = log.head.version + 1; v <= to; ++v) {
+      add(mk_ple_mod(mk_obj(v), mk_evt(1, v), mk_evt(1, v - 1),
+		     osd_reqid_t(client, 8, v)));
+    }
+    info.last_update = info.last_complete = log.head;
+  }
+
+  void write() {
+    ObjectStore::Transaction t;
+    map<string, bufferlist> km;
+    write_log_and_missing(t, &km, test_coll, log_oid, false);
+    if (!km.empty()) {
+      t.omap_setkeys(test_coll, log_oid, km);
+    }
+    ASSERT_EQ(0, store->queue_transaction(ch, std::move(t)));
+  }
+
+  void check_on_disk() {
+    set<string> keys;
+    ASSERT_EQ(0, store->omap_get_keys(ch, log_oid, &keys));
+    set<string> log_keys, dup_keys;
+    for (auto& k : keys) {
+      if (isdigit(k[0])) {
+	log_keys.insert(k);
+      } else if (k.starts_with("dup_")) {
+	dup_keys.insert(k);
+      }
+    }
+    set<string> expected_log_keys, expected_dup_keys;
+    for (auto& e : log.log) {
+      expected_log_keys.insert(e.get_key_name());
+    }
+    for (auto& d : log.dups) {
+      expected_dup_keys.insert(d.get_key_name());
+    }
+    EXPECT_EQ(expected_log_keys, log_keys);
+    EXPECT_EQ(expected_dup_keys, dup_keys);
+  }
+};
+
+TEST_F(PGLogOnDiskTrimTest, TrimRemovesKeyRanges) {
+  log.head = mk_evt(1, 100);
+  log.skip_can_rollback_to_to_head();
+  log.head = mk_evt(1, 0);
+  add_up_to(10);
+  write();
+  check_on_disk();
+
+  // entries 1..8 go, 7 and 8 become dups
+  trim(mk_evt(1, 8), info);
+  write();
+  EXPECT_EQ(2u, log.dups.size());
+  check_on_disk();
+
+  // a single trimmed entry takes the per-key path
+  add_up_to(12);
+  trim(mk_evt(1, 9), info);
+  write();
+  check_on_disk();
+
+  // enough dups now that the oldest are trimmed as well
+  add_up_to(20);
+  trim(mk_evt(1, 19), info);
+  write();
+  EXPECT_EQ(4u, log.dups.size());
+  check_on_disk();
+}
 
 class PGLogMergeDupsTest : protected PGLog, public StoreTestFixture {
 
@@ -3244,6 +3352,83 @@ TEST_F(PGLogTrimTest, TestCopyAfter2) {
   EXPECT_EQ(7u, copy.dups.size()) << copy;
 }
 
+TEST(PGLogIndex, MatchesUnorderedMap) {
+  // the index only stores entry pointers, so the dups must not move
+  std::deque<pg_log_dup_t> dups;
+  entity_name_t client = entity_name_t::CLIENT(777);
+  for (unsigned i = 0; i < 512; ++i) {
+    dups.emplace_back(eversion_t(1, i + 1), i,
+		      osd_reqid_t(client, 0, i), 0);
+  }
+
+  PGLogIndex<pg_log_dup_t, osd_reqid_t, &pg_log_dup_t::reqid> index;
+  std::unordered_map<osd_reqid_t, pg_log_dup_t*> ref;
+  std::mt19937 rng(42);
+  for (unsigned n = 0; n < 20000; ++n) {
+    auto& d = dups[rng() % dups.size()];
+    if (rng() % 3) {
+      index.insert_or_assign(&d);
+      ref[d.reqid] = &d;
+    } else {
+      EXPECT_EQ(ref.erase(d.reqid), index.erase(d.reqid));
+    }
+    ASSERT_EQ(ref.size(), index.size());
+  }
+  for (auto& d : dups) {
+    auto p = ref.find(d.reqid);
+    auto q = index.find(d.reqid);
+    if (p == ref.end()) {
+      EXPECT_EQ(0u, index.count(d.reqid));
+      EXPECT_TRUE(q == index.end());
+    } else {
+      ASSERT_FALSE(q == index.end());
+      EXPECT_EQ(p->second, q->second);
+      EXPECT_EQ(d.reqid, q->first);
+    }
+  }
+  size_t n = 0;
+  for (auto p = index.begin(); p != index.end(); ++p, ++n) {
+    EXPECT_EQ(1u, ref.count(p->first));
+  }
+  EXPECT_EQ(ref.size(), n);
+
+  index.clear();
+  EXPECT_TRUE(index.empty());
+  EXPECT_TRUE(index.begin() == index.end());
+}
+
+TEST_F(PGLogTrimTest, TestIndexLargeLog) {
+  SetUp(3000);
+  PGLog::IndexedLog log;
+  entity_name_t client = entity_name_t::CLIENT(777);
+  constexpr unsigned num = 3000;
+  for (unsigned i = 1; i <= num; ++i) {
+    // every object is written twice
+    log.add(mk_ple_mod(mk_obj(i % (num / 2)), mk_evt(1, i), mk_evt(1, i - 1),
+		       osd_reqid_t(client, 8, i)));
+  }
+  log.index();
+  EXPECT_EQ(num / 2, log.objects.size());
+  EXPECT_EQ(num, log.caller_ops.size());
+  // one pointer per slot, at most 3/4 full
+  EXPECT_GE(log.objects.capacity() * 3 / 4, log.objects.size());
+  EXPECT_GE(log.caller_ops.capacity() * 3 / 4, log.caller_ops.size());
+
+  log.trim(cct, mk_evt(1, num / 2), nullptr, nullptr, nullptr);
+  EXPECT_EQ(num / 2, log.log.size());
+  EXPECT_EQ(num / 2, log.objects.size());
+  EXPECT_EQ(num / 2, log.caller_ops.size());
+  EXPECT_EQ(num / 2, log.dup_index.size());
+  for (auto& e : log.log) {
+    ASSERT_TRUE(log.logged_object(e.soid));
+    EXPECT_EQ(&e, log.objects.find(e.soid)->second);
+    EXPECT_EQ(&e, log.caller_ops.find(e.reqid)->second);
+  }
+  for (auto& d : log.dups) {
+    EXPECT_EQ(&d, log.dup_index.find(d.reqid)->second);
+  }
+}
+
 // Local Variables:
 // compile-command: "cd ../.. ; make unittest_pglog ; ./unittest_pglog --log-to-stderr=true  --debug-osd=20 # --gtest_filter=*.* "
 // End:
@@ -0,0 +1,482 @@
+// -*- mode:C++; tab-width:8; c-basic-offset:2; indent-tabs-mode:t -*-
+// vim: ts=8 sw=2 smarttab
+/*
+ * Ceph - scalable distributed file system
+ *
+ * This is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License version 2.1, as published by the Free Software
+ * Foundation. See file COPYING.
+ *
+ */
+
+#include <gtest/gtest.h>
+#include "global/global_context.h"
+#include "include/stringify.h"
+#include "os/ObjectStore.h"
+#include "osd/ReplicatedBackend.h"
+#include "osd/osd_perf_counters.h"
+#include "test/objectstore/store_test_fixture.h"
+
+using namespace std;
+
+namespace {
+
+/// a PG that records what the backend tells it about a push
+class PushListener : public PGBackend::Listener {
+public:
+  pg_info_t info;
+  PerfCounters *logger;
+  std::vector<pg_shard_t> peers_recovered;
+  unsigned global_recovered = 0;
+  unsigned failed_pulls = 0;
+  unsigned locks_released = 0;
+
+  explicit PushListener(const spg_t &pgid)
+    : logger(build_osd_logger(g_ceph_context)) {
+    info.pgid = pgid;
+  }
+  ~PushListener() override {
+    delete logger;
+  }
+
+  // what the push path uses
+  std::ostream& gen_dbg_prefix(std::ostream& out) const override {
+    return out << "push_test ";
+  }
+  void on_peer_recover(
+    pg_shard_t peer,
+    const hobject_t &oid,
+    const ObjectRecoveryInfo &recovery_info) override {
+    peers_recovered.push_back(peer);
+  }
+  void on_global_recover(
+    const hobject_t &oid,
+    const object_stat_sum_t &stat_diff,
+    bool is_delete) override {
+    ++global_recovered;
+  }
+  void on_failed_pull(
+    const std::set<pg_shard_t> &from,
+    const hobject_t &soid,
+    const eversion_t &v) override {
+    ++failed_pulls;
+  }
+  void release_locks(ObcLockManager &manager) override {
+    ++locks_released;
+  }
+  const pg_info_t &get_info() const override {
+    return info;
+  }
+  bool pg_is_repair() const override {
+    return false;
+  }
+  pg_shard_t whoami_shard() const override {
+    return pg_shard_t(0);
+  }
+  PerfCounters *get_logger() override {
+    return logger;
+  }
+  OstreamTemp clog_error() override {
+    return OstreamTemp(CLOG_ERROR, nullptr);
+  }
+  OstreamTemp clog_warn() override {
+    return OstreamTemp(CLOG_WARN, nullptr);
+  }
+
+  // not expected to be called by the push path
+  DoutPrefixProvider *get_dpp() override {
+    ceph_abort_msg("unexpected");
+  }
+  void on_local_recover(
+    const hobject_t &oid,
+    const ObjectRecoveryInfo &recovery_info,
+    ObjectContextRef obc,
+    bool is_delete,
+    ObjectStore::Transaction *t) override {
+    ceph_abort_msg("unexpected");
+  }
+  void begin_peer_recover(pg_shard_t peer, const hobject_t oid) override {
+    ceph_abort_msg("unexpected");
+  }
+  void apply_stats(
+    const hobject_t &soid,
+    const object_stat_sum_t &delta_stats) override {
+    ceph_abort_msg("unexpected");
+  }
+  void cancel_pull(const hobject_t &soid) override {
+    ceph_abort_msg("unexpected");
+  }
+  void remove_missing_object(
+    const hobject_t &oid,
+    eversion_t v,
+    Context *on_complete) override {
+    ceph_abort_msg("unexpected");
+  }
+  Context *bless_context(Context *c) override {
+    ceph_abort_msg("unexpected");
+  }
+  GenContext<ThreadPool::TPHandle&> *bless_gencontext(
+    GenContext<ThreadPool::TPHandle&> *c) override {
+    ceph_abort_msg("unexpected");
+  }
+  GenContext<ThreadPool::TPHandle&> *bless_unlocked_gencontext(
+    GenContext<ThreadPool::TPHandle&> *c) override {
+    ceph_abort_msg("unexpected");
+  }
+  void send_message(int to_osd, Message *m) override {
+    ceph_abort_msg("unexpected");
+  }
+  void queue_transaction(
+    ObjectStore::Transaction&& t,
+    OpRequestRef op) override {
+    ceph_abort_msg("unexpected");
+  }
+  void queue_transactions(
+    std::vector<ObjectStore::Transaction>& tls,
+    OpRequestRef op) override {
+    ceph_abort_msg("unexpected");
+  }
+  epoch_t get_interval_start_epoch() const override {
+    ceph_abort_msg("unexpected");
+  }
+  epoch_t get_last_peering_reset_epoch() const override {
+    ceph_abort_msg("unexpected");
+  }
+  const std::set<pg_shard_t> &get_acting_recovery_backfill_shards() const override {
+    ceph_abort_msg("unexpected");
+  }
+  const std::set<pg_shard_t> &get_acting_shards() const override {
+    ceph_abort_msg("unexpected");
+  }
+  const std::set<pg_shard_t> &get_backfill_shards() const override {
+    ceph_abort_msg("unexpected");
+  }
+  const std::map<hobject_t, std::set<pg_shard_t>> &get_missing_loc_shards()
+    const override {
+    ceph_abort_msg("unexpected");
+  }
+  const pg_missing_tracker_t &get_local_missing() const override {
+    ceph_abort_msg("unexpected");
+  }
+  void add_local_next_event(const pg_log_entry_t& e) override {
+    ceph_abort_msg("unexpected");
+  }
+  const std::map<pg_shard_t, pg_missing_t> &get_shard_missing()
+    const override {
+    ceph_abort_msg("unexpected");
+  }
+  const pg_missing_const_i &get_shard_missing(pg_shard_t peer) const override {
+    ceph_abort_msg("unexpected");
+  }
+  const std::map<pg_shard_t, pg_info_t> &get_shard_info() const override {
+    ceph_abort_msg("unexpected");
+  }
+  const PGLog &get_log() const override {
+    ceph_abort_msg("unexpected");
+  }
+  bool pgb_is_primary() const override {
+    ceph_abort_msg("unexpected");
+  }
+  const OSDMapRef& pgb_get_osdmap() const override {
+    ceph_abort_msg("unexpected");
+  }
+  epoch_t pgb_get_osdmap_epoch() const override {
+    ceph_abort_msg("unexpected");
+  }
+  const pg_pool_t &get_pool() const override {
+    ceph_abort_msg("unexpected");
+  }
+  ObjectContextRef get_obc(
+    const hobject_t &hoid,
+    const std::map<std::string, ceph::buffer::list, std::less<>> &attrs) override {
+    ceph_abort_msg("unexpected");
+  }
+  bool try_lock_for_read(
+    const hobject_t &hoid,
+    ObcLockManager &manager) override {
+    ceph_abort_msg("unexpected");
+  }
+  void op_applied(const eversion_t &applied_version) override {
+    ceph_abort_msg("unexpected");
+  }
+  bool should_send_op(pg_shard_t peer, const hobject_t &hoid) override {
+    ceph_abort_msg("unexpected");
+  }
+  bool pg_is_undersized() const override {
+    ceph_abort_msg("unexpected");
+  }
+  void log_operation(
+    std::vector<pg_log_entry_t>&& logv,
+    const std::optional<pg_hit_set_history_t> &hset_history,
+    const eversion_t &trim_to,
+    const eversion_t &roll_forward_to,
+    const eversion_t &min_last_complete_ondisk,
+    bool transaction_applied,
+    ObjectStore::Transaction &t,
+    bool async) override {
+    ceph_abort_msg("unexpected");
+  }
+  void pgb_set_object_snap_mapping(
+    const hobject_t &soid,
+    const std::set<snapid_t> &snaps,
+    ObjectStore::Transaction *t) override {
+    ceph_abort_msg("unexpected");
+  }
+  void pgb_clear_object_snap_mapping(
+    const hobject_t &soid,
+    ObjectStore::Transaction *t) override {
+    ceph_abort_msg("unexpected");
+  }
+  void update_peer_last_complete_ondisk(
+    pg_shard_t fromosd,
+    eversion_t lcod) override {
+    ceph_abort_msg("unexpected");
+  }
+  void update_last_complete_ondisk(eversion_t lcod) override {
+    ceph_abort_msg("unexpected");
+  }
+  void update_stats(const pg_stat_t &stat) override {
+    ceph_abort_msg("unexpected");
+  }
+  void schedule_recovery_work(
+    GenContext<ThreadPool::TPHandle&> *c,
+    uint64_t cost) override {
+    ceph_abort_msg("unexpected");
+  }
+  spg_t primary_spg_t() const override {
+    ceph_abort_msg("unexpected");
+  }
+  pg_shard_t primary_shard() const override {
+    ceph_abort_msg("unexpected");
+  }
+  uint64_t min_peer_features() const override {
+    ceph_abort_msg("unexpected");
+  }
+  uint64_t min_upacting_features() const override {
+    ceph_abort_msg("unexpected");
+  }
+  hobject_t get_temp_recovery_object(const hobject_t& target,
+				     eversion_t version) override {
+    ceph_abort_msg("unexpected");
+  }
+  void send_message_osd_cluster(
+    int peer, Message *m, epoch_t from_epoch) override {
+    ceph_abort_msg("unexpected");
+  }
+  void send_message_osd_cluster(
+    std::vector<std::pair<int, Message*>>& messages,
+    epoch_t from_epoch) override {
+    ceph_abort_msg("unexpected");
+  }
+  void send_message_osd_cluster(MessageRef, Connection *con) override {
+    ceph_abort_msg("unexpected");
+  }
+  void send_message_osd_cluster(
+    Message *m, const ConnectionRef& con) override {
+    ceph_abort_msg("unexpected");
+  }
+  ConnectionRef get_con_osd_cluster(int peer, epoch_t from_epoch) override {
+    ceph_abort_msg("unexpected");
+  }
+  entity_name_t get_cluster_msgr_name() override {
+    ceph_abort_msg("unexpected");
+  }
+  ceph_tid_t get_tid() override {
+    ceph_abort_msg("unexpected");
+  }
+  bool check_failsafe_full() override {
+    ceph_abort_msg("unexpected");
+  }
+  void inc_osd_stat_repaired() override {
+    ceph_abort_msg("unexpected");
+  }
+  bool pg_is_remote_backfilling() override {
+    ceph_abort_msg("unexpected");
+  }
+  void pg_add_local_num_bytes(int64_t num_bytes) override {
+    ceph_abort_msg("unexpected");
+  }
+  void pg_sub_local_num_bytes(int64_t num_bytes) override {
+    ceph_abort_msg("unexpected");
+  }
+  void pg_add_num_bytes(int64_t num_bytes) override {
+    ceph_abort_msg("unexpected");
+  }
+  void pg_sub_num_bytes(int64_t num_bytes) override {
+    ceph_abort_msg("unexpected");
+  }
+  bool maybe_preempt_replica_scrub(const hobject_t& oid) override {
+    ceph_abort_msg("unexpected");
+  }
+  ECListener *get_eclistener() override {
+    ceph_abort_msg("unexpected");
+  }
+};
+
+constexpr uint64_t CHUNK = 4096;
+constexpr unsigned NUM_CHUNKS = 5;
+
+} // anonymous namespace
+
+/// pushes an object of NUM_CHUNKS chunks from a memstore to a peer
+class ReplicatedBackendTest : public StoreTestFixture {
+public:
+  const spg_t pgid{pg_t(0, 1)};
+  const coll_t cid{pgid};
+  const hobject_t soid{object_t("obj"), "", CEPH_NOSNAP, 0, 1, ""};
+  const pg_shard_t peer{1};
+  const eversion_t version{1, 1};
+  bufferlist content;
+  std::unique_ptr<PushListener> listener;
+  std::unique_ptr<ReplicatedBackend> backend;
+
+  ReplicatedBackendTest() : StoreTestFixture("memstore") {}
+
+  void SetUp() override {
+    StoreTestFixture::SetUp();
+    SetVal(g_conf(), "osd_recovery_max_chunk", stringify(CHUNK).c_str());
+    for (unsigned i = 0; i < NUM_CHUNKS; ++i) {
+      content.append(std::string(CHUNK, 'a' + i));
+    }
+    object_info_t oi(soid);
+    oi.version = version;
+    oi.size = content.length();
+    bufferlist enc_oi;
+    encode(oi, enc_oi, 0);
+
+    ch = store->create_new_collection(cid);
+    ObjectStore::Transaction t;
+    t.create_collection(cid, 0);
+    t.write(cid, ghobject_t(soid), 0, content.length(), content);
+    t.setattr(cid, ghobject_t(soid), OI_ATTR, enc_oi);
+    ASSERT_EQ(0, store->queue_transaction(ch, std::move(t)));
+
+    listener = std::make_unique<PushListener>(pgid);
+    backend = std::make_unique<ReplicatedBackend>(
+      listener.get(), cid, ch, store.get(), g_ceph_context);
+  }
+
+  void TearDown() override {
+    backend.reset();
+    listener.reset();
+    ch.reset();
+    StoreTestFixture::TearDown();
+  }
+
+  /// start pushing soid to peer, as start_pushes() does after the first chunk
+  void start_push(unsigned depth, std::vector<PushOp> *pops) {
+    SetVal(g_conf(), "osd_recovery_push_pipeline_depth",
+	   stringify(depth).c_str());
+    auto& pi = backend->pushing[soid][peer];
+    pi.recovery_info.soid = soid;
+    pi.recovery_info.version = version;
+    pi.recovery_info.size = content.length();
+    pi.recovery_info.copy_subset.insert(0, content.length());
+    pi.recovery_progress.omap_complete = true;
+    backend->fill_push_pipeline(soid, peer, pops);
+  }
+  /// the peer acked a chunk; true if reply holds the next one to send
+  bool ack(PushOp *reply) {
+    PushReplyOp op;
+    op.soid = soid;
+    return backend->handle_push_reply(peer, op, reply);
+  }
+  unsigned chunks_in_flight() {
+    auto p = backend->pushing.find(soid);
+    if (p == backend->pushing.end() || !p->second.count(peer)) {
+      return 0;
+    }
+    return p->second[peer].chunks_in_flight;
+  }
+  bool is_pushing() {
+    return backend->pushing.count(soid);
+  }
+  /// fail every read of a chunk from now on
+  void inject_read_error() {
+    // build_push_op() fails if rand() % (int)(ratio * 100) == 0, i.e. always
+    SetVal(g_conf(), "osd_debug_random_push_read_error", "0.015");
+  }
+};
+
+TEST_F(ReplicatedBackendTest, PipelineInOrder) {
+  std::vector<PushOp> pops;
+  start_push(3, &pops);
+  ASSERT_EQ(3u, pops.size());
+  ASSERT_EQ(3u, chunks_in_flight());
+  EXPECT_TRUE(pops[0].before_progress.first);
+
+  // every ack of a chunk sends the next one, keeping 3 in flight
+  for (unsigned i = 3; i < NUM_CHUNKS; ++i) {
+    PushOp reply;
+    ASSERT_TRUE(ack(&reply));
+    pops.push_back(std::move(reply));
+    ASSERT_EQ(3u, chunks_in_flight());
+  }
+  ASSERT_EQ(NUM_CHUNKS, pops.size());
+  EXPECT_TRUE(pops.back().after_progress.data_complete);
+
+  // chunks are consecutive, each picks up where the previous one stopped
+  bufferlist pushed;
+  for (unsigned i = 0; i < NUM_CHUNKS; ++i) {
+    SCOPED_TRACE(i);
+    EXPECT_EQ(i > 0 ? pops[i - 1].after_progress.data_recovered_to : 0,
+	      pops[i].before_progress.data_recovered_to);
+    ASSERT_EQ(1u, pops[i].data_included.num_intervals());
+    EXPECT_EQ(i * CHUNK, pops[i].data_included.range_start());
+    EXPECT_EQ(CHUNK, pops[i].data_included.size());
+    pushed.append(pops[i].data);
+  }
+  EXPECT_TRUE(pushed.contents_equal(content));
+}
+
+TEST_F(ReplicatedBackendTest, LastChunkCompletes) {
+  std::vector<PushOp> pops;
+  start_push(8, &pops);
+  // the pipeline is deeper than the object: it is all in flight
+  ASSERT_EQ(NUM_CHUNKS, pops.size());
+  ASSERT_EQ(NUM_CHUNKS, chunks_in_flight());
+  EXPECT_TRUE(pops.back().after_progress.data_complete);
+
+  for (unsigned i = 1; i < NUM_CHUNKS; ++i) {
+    PushOp reply;
+    ASSERT_FALSE(ack(&reply));
+    EXPECT_EQ(NUM_CHUNKS - i, chunks_in_flight());
+    EXPECT_TRUE(listener->peers_recovered.empty());
+    EXPECT_EQ(0u, listener->global_recovered);
+  }
+  // only the ack of the last chunk completes the push
+  PushOp reply;
+  ASSERT_FALSE(ack(&reply));
+  EXPECT_FALSE(is_pushing());
+  ASSERT_EQ(1u, listener->peers_recovered.size());
+  EXPECT_EQ(peer, listener->peers_recovered[0]);
+  EXPECT_EQ(1u, listener->global_recovered);
+  EXPECT_EQ(1u, listener->locks_released);
+  EXPECT_EQ(0u, listener->failed_pulls);
+}
+
+TEST_F(ReplicatedBackendTest, ErrorWithChunksInFlight) {
+  std::vector<PushOp> pops;
+  start_push(3, &pops);
+  ASSERT_EQ(3u, pops.size());
+
+  // reading the next chunk fails: nothing more is sent, but the object
+  // is only failed once the chunks already sent are acked
+  inject_read_error();
+  PushOp reply;
+  ASSERT_FALSE(ack(&reply));
+  EXPECT_TRUE(is_pushing());
+  EXPECT_EQ(2u, chunks_in_flight());
+  ASSERT_FALSE(ack(&reply));
+  EXPECT_TRUE(is_pushing());
+  EXPECT_EQ(1u, chunks_in_flight());
+  EXPECT_EQ(0u, listener->failed_pulls);
+
+  ASSERT_FALSE(ack(&reply));
+  EXPECT_FALSE(is_pushing());
+  EXPECT_EQ(1u, listener->failed_pulls);
+  EXPECT_TRUE(listener->peers_recovered.empty());
+  EXPECT_EQ(0u, listener->global_recovered);
+  EXPECT_EQ(1u, listener->locks_released);
+}
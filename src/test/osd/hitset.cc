@@ -11,6 +11,7 @@
  */
 
 #include "gtest/gtest.h"
+#include "common/ceph_time.h"
 #include "osd/HitSet.h"
 #include <iostream>
 
@@ -126,6 +127,165 @@ TEST_F(BloomHitSetTest, RejectsNoMatch) {
   EXPECT_LT(matches, 2);
 }
 
+class BlockedBloomHitSetTest : public testing::Test, public HitSetTestStrap {
+public:
+
+  BlockedBloomHitSetTest() : HitSetTestStrap(new HitSet(new BlockedBloomHitSet)) {}
+
+  void rebuild(double fp, uint64_t target, uint64_t seed) {
+    auto *bparams = new BlockedBloomHitSet::Params(fp, target, seed);
+    HitSet::Params param(bparams);
+    HitSet new_set(param);
+    *hitset = new_set;
+  }
+
+  BlockedBloomHitSet *get_hitset() { return static_cast<BlockedBloomHitSet*>(hitset->impl.get()); }
+};
+
+TEST_F(BlockedBloomHitSetTest, Params) {
+  BlockedBloomHitSet::Params params(0.01, 100, 5);
+  EXPECT_EQ(HitSet::TYPE_BLOCKED_BLOOM, params.get_type());
+
+  HitSet::Params hsp(new BlockedBloomHitSet::Params(params));
+  bufferlist bl;
+  encode(hsp, bl);
+  HitSet::Params p2;
+  auto iter = bl.cbegin();
+  decode(p2, iter);
+  ASSERT_EQ(HitSet::TYPE_BLOCKED_BLOOM, p2.get_type());
+  ASSERT_TRUE(HitSet::is_bloom_type(p2.get_type()));
+  auto bp = static_cast<BloomHitSet::Params*>(p2.impl.get());
+  EXPECT_EQ(.01, bp->get_fpp());
+  EXPECT_EQ((unsigned)100, bp->target_size);
+  EXPECT_EQ((unsigned)5, bp->seed);
+}
+
+TEST_F(BlockedBloomHitSetTest, Rebuild) {
+  rebuild(0.1, 100, 1);
+  ASSERT_EQ(hitset->impl->get_type(), HitSet::TYPE_BLOCKED_BLOOM);
+}
+
+TEST_F(BlockedBloomHitSetTest, InsertsMatch) {
+  rebuild(0.1, 100, 1);
+  fill(50);
+  EXPECT_GE(hitset->approx_unique_insert_count(), 45u);
+  EXPECT_LE(hitset->approx_unique_insert_count(), 50u);
+  verify_fill(50);
+  EXPECT_FALSE(hitset->is_full());
+}
+
+TEST_F(BlockedBloomHitSetTest, FillsUp) {
+  rebuild(0.1, 20, 1);
+  fill(20);
+  verify_fill(20);
+  EXPECT_TRUE(hitset->is_full());
+}
+
+TEST_F(BlockedBloomHitSetTest, RejectsNoMatch) {
+  rebuild(0.001, 100, 1);
+  fill(100);
+  verify_fill(100);
+  EXPECT_TRUE(hitset->is_full());
+
+  char buf[50];
+  int matches = 0;
+  for (int i = 100; i < 200; ++i) {
+    sprintf(buf, "hitsettest_%d", i);
+    hobject_t obj(object_t(buf), "", 0, i, 0, "");
+    if (hitset->contains(obj))
+      ++matches;
+  }
+  EXPECT_LT(matches, 2);
+}
+
+TEST_F(BlockedBloomHitSetTest, SealAndEncode) {
+  rebuild(0.01, 10000, 3);
+  size_t size = get_hitset()->get_size();
+  fill(100);
+  hitset->seal();
+  // barely used, so sealing folds it down
+  EXPECT_LT(get_hitset()->get_size(), size);
+  EXPECT_LE(get_hitset()->density(), .5);
+  verify_fill(100);
+
+  bufferlist bl;
+  encode(*hitset, bl);
+  HitSet copy;
+  auto p = bl.cbegin();
+  decode(copy, p);
+  ASSERT_EQ(HitSet::TYPE_BLOCKED_BLOOM, copy.impl->get_type());
+  EXPECT_TRUE(copy.sealed);
+  EXPECT_EQ(100u, copy.insert_count());
+  delete hitset;
+  hitset = new HitSet(copy);
+  verify_fill(100);
+}
+
+TEST(BlockedBloomHitSet, DecodeBadBlockCount) {
+  // a block count far beyond what the encoding holds must be rejected
+  // before anything is allocated for it
+  bufferlist bl;
+  ENCODE_START(1, 1, bl);
+  encode((uint64_t)0, bl);    // count
+  encode((uint64_t)100, bl);  // target_size
+  encode((uint64_t)1, bl);    // seed
+  encode((uint32_t)0xffffffff, bl);
+  for (unsigned i = 0; i < BlockedBloomHitSet::WORDS_PER_BLOCK; ++i) {
+    encode((uint32_t)0, bl);
+  }
+  ENCODE_FINISH(bl);
+  BlockedBloomHitSet h;
+  auto p = bl.cbegin();
+  EXPECT_THROW(h.decode(p), ceph::buffer::malformed_input);
+}
+
+TEST(BlockedBloomHitSet, CompareWithBloom) {
+  // object counts a cache tier or temperature tracking hit set sees
+  // in one hit_set_period
+  for (unsigned n : {1000, 10000, 100000}) {
+    for (double fpp : {.05, .01, .001}) {
+      std::vector<hobject_t> objs;
+      for (unsigned i = 0; i < 2 * n; ++i) {
+	objs.emplace_back(object_t("obj_" + std::to_string(i)), "", CEPH_NOSNAP,
+			  rand(), 1, "");
+      }
+      HitSet bloom(new BloomHitSet(n, fpp, 1));
+      HitSet blocked(new BlockedBloomHitSet(n, fpp, 1));
+      for (auto* hs : {&bloom, &blocked}) {
+	auto start = mono_clock::now();
+	for (unsigned i = 0; i < n; ++i) {
+	  hs->insert(objs[i]);
+	}
+	auto insert_lat = mono_clock::now() - start;
+	start = mono_clock::now();
+	unsigned fp = 0;
+	for (unsigned i = 0; i < 2 * n; ++i) {
+	  bool c = hs->contains(objs[i]);
+	  if (i < n) {
+	    ASSERT_TRUE(c);
+	  } else if (c) {
+	    ++fp;
+	  }
+	}
+	auto lookup_lat = mono_clock::now() - start;
+	bufferlist bl;
+	hs->seal();
+	hs->encode(bl);
+	double measured = (double)fp / n;
+	std::cout << hs->get_type_name() << " n " << n << " fpp " << fpp
+		  << ": measured fpp " << measured
+		  << ", inserts/s " << n / std::chrono::duration<double>(insert_lat).count()
+		  << ", lookups/s " << 2 * n / std::chrono::duration<double>(lookup_lat).count()
+		  << ", encoded " << bl.length() << " bytes" << std::endl;
+	if (hs == &blocked) {
+	  // allow for sampling noise at the small end
+	  EXPECT_LT(measured, fpp * 1.5 + 5.0 / n);
+	}
+      }
+    }
+  }
+}
+
 class ExplicitHashHitSetTest : public testing::Test, public HitSetTestStrap {
 public:
 
@@ -260,6 +260,101 @@ TEST(PerfCounters, read_avg) {
   t1.join();
 }
 
+enum {
+  TEST_PERFCOUNTERS5_ELEMENT_FIRST = 600,
+  TEST_PERFCOUNTERS5_ELEMENT_OPS,
+  TEST_PERFCOUNTERS5_ELEMENT_LAT,
+  TEST_PERFCOUNTERS5_ELEMENT_LAST,
+};
+
+static std::shared_ptr<PerfCounters> setup_test_perfcounter5(
+  CephContext* cct, bool sharded)
+{
+  PerfCountersBuilder bld(cct, "test_perfcounter_5",
+	  TEST_PERFCOUNTERS5_ELEMENT_FIRST, TEST_PERFCOUNTERS5_ELEMENT_LAST);
+  bld.add_u64_counter(TEST_PERFCOUNTERS5_ELEMENT_OPS, "ops");
+  bld.add_time_avg(TEST_PERFCOUNTERS5_ELEMENT_LAT, "lat");
+  if (sharded) {
+    bld.set_sharded(TEST_PERFCOUNTERS5_ELEMENT_OPS);
+    bld.set_sharded(TEST_PERFCOUNTERS5_ELEMENT_LAT);
+  }
+  return std::shared_ptr<PerfCounters>(bld.create_perf_counters());
+}
+
+TEST(PerfCounters, Sharded) {
+  auto pc = setup_test_perfcounter5(g_ceph_context, true);
+  const int num_threads = 8;
+  const int num_ops = 20000;
+  std::atomic<bool> done = false;
+
+  // like read_avg above: every sample is 1ns, so sum and count must agree
+  std::thread reader([&] {
+    while (!done) {
+      auto a = pc->get_tavg_ns(TEST_PERFCOUNTERS5_ELEMENT_LAT);
+      ASSERT_EQ(a.first, a.second);
+    }
+  });
+  std::vector<std::thread> writers;
+  for (int t = 0; t < num_threads; ++t) {
+    writers.emplace_back([&] {
+      for (int i = 0; i < num_ops; ++i) {
+	pc->inc(TEST_PERFCOUNTERS5_ELEMENT_OPS);
+	pc->tinc(TEST_PERFCOUNTERS5_ELEMENT_LAT, ceph::timespan(1));
+      }
+    });
+  }
+  for (auto& t : writers) {
+    t.join();
+  }
+  done = true;
+  reader.join();
+
+  ASSERT_EQ(uint64_t(num_threads * num_ops),
+	    pc->get(TEST_PERFCOUNTERS5_ELEMENT_OPS));
+  auto a = pc->get_tavg_ns(TEST_PERFCOUNTERS5_ELEMENT_LAT);
+  ASSERT_EQ(uint64_t(num_threads * num_ops), a.first);
+  ASSERT_EQ(uint64_t(num_threads * num_ops), a.second);
+
+  pc->dec(TEST_PERFCOUNTERS5_ELEMENT_OPS, 10);
+  ASSERT_EQ(uint64_t(num_threads * num_ops - 10),
+	    pc->get(TEST_PERFCOUNTERS5_ELEMENT_OPS));
+  pc->set(TEST_PERFCOUNTERS5_ELEMENT_OPS, 5);
+  ASSERT_EQ(5u, pc->get(TEST_PERFCOUNTERS5_ELEMENT_OPS));
+  pc->reset();
+  ASSERT_EQ(0u, pc->get(TEST_PERFCOUNTERS5_ELEMENT_OPS));
+  ASSERT_EQ(0u, pc->get_tavg_ns(TEST_PERFCOUNTERS5_ELEMENT_LAT).first);
+}
+
+TEST(PerfCounters, BenchSharded) {
+  const int num_threads =
+    std::clamp(std::thread::hardware_concurrency(), 2u, 16u);
+  const int num_ops = 1000000;
+  for (bool sharded : {false, true}) {
+    auto pc = setup_test_perfcounter5(g_ceph_context, sharded);
+    auto start = ceph::mono_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&] {
+	for (int i = 0; i < num_ops; ++i) {
+	  pc->inc(TEST_PERFCOUNTERS5_ELEMENT_OPS);
+	  pc->tinc(TEST_PERFCOUNTERS5_ELEMENT_LAT, ceph::timespan(1));
+	}
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    auto elapsed = ceph::mono_clock::now() - start;
+    std::cout << (sharded ? "sharded" : "shared") << ": " << num_threads
+	      << " threads, inc + tinc took "
+	      << std::chrono::duration<double, std::nano>(elapsed).count() /
+		 num_ops
+	      << " ns per op per thread" << std::endl;
+    ASSERT_EQ(uint64_t(num_threads) * num_ops,
+	      pc->get(TEST_PERFCOUNTERS5_ELEMENT_OPS));
+  }
+}
+
 static PerfCounters* setup_test_perfcounter4(std::string name, CephContext *cct)
 {
   PerfCountersBuilder bld(cct, name,
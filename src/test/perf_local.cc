@@ -51,6 +51,7 @@
 #include "common/ceph_mutex.h"
 #include "common/Thread.h"
 #include "common/Timer.h"
+#include "common/TrackedOp.h"
 #include "msg/async/Event.h"
 #include "global/global_init.h"
 
@@ -915,6 +916,40 @@ double perf_ceph_clock_now()
   return Cycles::to_seconds(stop - start)/count;
 }
 
+class PerfTrackedOp : public TrackedOp {
+ public:
+  explicit PerfTrackedOp(OpTracker *tracker)
+    : TrackedOp(tracker, ceph_clock_now()) {}
+  void _dump_op_descriptor(std::ostream& stream) const override {
+    stream << "perf_local";
+  }
+};
+
+// Measure the cost of TrackedOp::mark_event, by name or by well known stage
+template <bool by_stage>
+double op_mark_event()
+{
+  int count = 10000;
+  int events = 10;
+  OpTracker tracker(g_ceph_context, true, 1);
+  uint64_t cycles = 0;
+  for (int i = 0; i < count; i++) {
+    TrackedOpRef op(new PerfTrackedOp(&tracker));
+    op->tracking_start();
+    uint64_t start = Cycles::rdtsc();
+    for (int j = 0; j < events; j++) {
+      if constexpr (by_stage) {
+        op->mark_event(op_stage_t::queued_for_pg);
+      } else {
+        op->mark_event("queued_for_pg");
+      }
+    }
+    cycles += Cycles::rdtsc() - start;
+  }
+  tracker.on_shutdown();
+  return Cycles::to_seconds(cycles)/(count*events);
+}
+
 // The following struct and table define each performance test in terms of
 // a string name and a function that implements the test.
 struct TestInfo {
@@ -1005,6 +1040,10 @@ TestInfo tests[] = {
     "Push and pop a std::vector"},
   {"ceph_clock_now", perf_ceph_clock_now,
    "ceph_clock_now function"},
+  {"op_mark_event", op_mark_event<false>,
+   "TrackedOp::mark_event by name"},
+  {"op_mark_stage", op_mark_event<true>,
+   "TrackedOp::mark_event by stage"},
 };
 
 /**
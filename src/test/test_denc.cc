@@ -22,6 +22,7 @@
 #include "global/global_context.h"
 #include "gtest/gtest.h"
 
+#include "common/ceph_time.h"
 #include "include/denc.h"
 
 using namespace std;
@@ -269,6 +270,66 @@ TEST(denc, vector)
   }
 }
 
+TEST(denc, vector_raw_layout)
+{
+  static_assert(_denc::raw_layout_v<ceph_le32>);
+  static_assert(!_denc::raw_layout_v<std::string>);
+  static_assert(!_denc::raw_layout_v<denc_counter_bounded_t>);
+
+  vector<uint64_t> v(1000);
+  std::iota(v.begin(), v.end(), 0x0102030405060708ull);
+  test_denc(v);
+  test_denc(vector<uint16_t>{});
+
+  // same bytes as encoding the elements one by one
+  bufferlist bl, expected;
+  encode(v, bl);
+  encode((uint32_t)v.size(), expected);
+  for (auto i : v) {
+    encode(i, expected);
+  }
+  ASSERT_EQ(expected, bl);
+
+  // decode from a segmented bufferlist
+  bufferlist segmented;
+  for (unsigned off = 0; off < bl.length(); off += 13) {
+    bufferlist seg;
+    seg.substr_of(bl, off, std::min(13u, bl.length() - off));
+    segmented.append(seg.c_str(), seg.length());
+  }
+  ASSERT_GT(segmented.get_num_buffers(), 1u);
+  vector<uint64_t> out;
+  auto p = segmented.cbegin();
+  denc(out, p);
+  ASSERT_EQ(v, out);
+
+  // a truncated run is an error, not a short vector
+  bufferlist truncated;
+  truncated.substr_of(bl, 0, bl.length() - 1);
+  auto q = truncated.cbegin();
+  ASSERT_THROW(decode(out, q), buffer::end_of_buffer);
+}
+
+TEST(denc, vector_raw_layout_bench)
+{
+  vector<uint64_t> v(4096);
+  std::iota(v.begin(), v.end(), 0);
+  vector<string> vs(v.size(), "x");
+  auto bench = [](const char *what, const auto& v) {
+    auto start = ceph::mono_clock::now();
+    for (int i = 0; i < 1000; ++i) {
+      bufferlist bl;
+      encode(v, bl);
+      std::decay_t<decltype(v)> out;
+      decode(out, bl);
+    }
+    cout << "1000 encode/decode of " << v.size() << " " << what << " in "
+         << ceph::mono_clock::now() - start << std::endl;
+  };
+  bench("uint64_t", v);
+  bench("1 byte strings", vs);
+}
+
 template<typename T>
 using default_list = std::list<T>;
 
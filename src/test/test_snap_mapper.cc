@@ -373,6 +373,31 @@ public:
       cur = next.first;
     }
   }
+  void get_next_n() {
+    string cur;
+    unsigned max = 1 + random_num();
+    while (true) {
+      vector<pair<string, bufferlist>> next;
+      int r = cache->get_next_n(cur, max, &next);
+
+      vector<pair<string, bufferlist>> next_truth;
+      for (auto i = truth.upper_bound(cur);
+	   i != truth.end() && next_truth.size() < max;
+	   ++i) {
+	next_truth.push_back(*i);
+      }
+      ASSERT_EQ(r, next_truth.empty() ? -ENOENT : 0);
+      if (r == -ENOENT)
+	break;
+
+      ASSERT_EQ(next.size(), next_truth.size());
+      for (size_t i = 0; i < next.size(); ++i) {
+	ASSERT_EQ(next[i].first, next_truth[i].first);
+	assert_bl_eq(next[i].second, next_truth[i].second);
+      }
+      cur = next.back().first;
+    }
+  }
   void SetUp() override {
     driver.reset(new PausyAsyncMap());
     cache.reset(new MapCacher::MapCacher<string, bufferlist>(driver.get()));
@@ -427,7 +452,7 @@ TEST_F(MapCacherTest, Random)
     if (!(i % 50)) {
       std::cout << "On iteration " << i << std::endl;
     }
-    switch (rand() % 4) {
+    switch (rand() % 5) {
     case 0:
       get();
       break;
@@ -440,6 +465,9 @@ TEST_F(MapCacherTest, Random)
     case 3:
       remove();
       break;
+    case 4:
+      get_next_n();
+      break;
     }
   }
 }